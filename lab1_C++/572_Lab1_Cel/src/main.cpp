@@ -1,6 +1,6 @@
-// main.cpp — OBJ loader + Cel (Toon) Shading with Outline (A/D rotate, W/S zoom)
+// main.cpp — OBJ loader + Cel (Toon) Shading with Outline (A/D rotate, W/S zoom, O outline mode)
 // Build (Linux): g++ main.cpp -std=c++17 -lglfw -ldl -lGL -o obj_cel
-// Run: ./obj_cel path/to/model.obj
+// Run: ./obj_cel path/to/model.obj [--screen-outline]
 // Windows/MSVC: link opengl32.lib + glfw3 + glad (or use vcpkg: `vcpkg install glfw3 glad`)
 
 #include <iostream>
@@ -11,7 +11,11 @@
 #include <cmath>
 #include <vector>
 #include <string>
+#include <fstream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 #include <GLFW/glfw3.h>
 
 #include <tiny_obj_loader/tiny_obj_loader.h>
@@ -88,7 +92,8 @@ uniform vec3 MatDif;
 uniform vec3 MatSpec;
 uniform float MatShine;
 
-out vec4 FragColor;
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 FragNormal; // screen-space outline input (ignored without the FBO)
 
 float stepBand(float x, float bands) { return floor(x * bands) / bands; }
 
@@ -113,6 +118,7 @@ void main() {
 
     vec3 color = MatAmb + dQ * MatDif + sQ * MatSpec + rimQ * vec3(1.0);
     FragColor = vec4(color, 1.0);
+    FragNormal = vec4(N * 0.5 + 0.5, 1.0);
 }
 )";
 
@@ -135,6 +141,83 @@ out vec4 FragColor;
 void main(){ FragColor = vec4(0.0,0.0,0.0,1.0); } // black outline
 )";
 
+// Screen-space outline: fullscreen pass over the cel FBO (color, view normal, depth).
+// Inks silhouettes and creases, so the mesh is drawn once instead of twice.
+static const char* edgeVS = R"(#version 330 core
+out vec2 uv;
+void main() {
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2); // fullscreen triangle
+    uv = p;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* edgeFS = R"(#version 330 core
+in vec2 uv;
+uniform sampler2D colorTex;
+uniform sampler2D normalTex; // rgb = view normal, a = 1 on the mesh
+uniform sampler2D depthTex;
+uniform mat4 P;
+uniform vec2 texelStep;      // outline thickness in uv units
+out vec4 FragColor;
+
+float viewDepth(vec2 t) {
+    float z = texture(depthTex, t).r * 2.0 - 1.0;
+    return P[3][2] / (z + P[2][2]);
+}
+
+void main() {
+    vec4 nc = texture(normalTex, uv);
+    float dc = viewDepth(uv);
+    vec2 offs[4] = vec2[](vec2(texelStep.x, 0.0), vec2(-texelStep.x, 0.0),
+                          vec2(0.0, texelStep.y), vec2(0.0, -texelStep.y));
+    float ink = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        vec4 nn = texture(normalTex, uv + offs[i]);
+        if (nn.a == 0.0) continue;
+        float dn = viewDepth(uv + offs[i]);
+        // silhouette: ink the far side, like the inflated hull
+        if (nc.a == 0.0 || dn < dc * 0.97) { ink = 1.0; break; }
+        // crease
+        if (dot(nc.xyz * 2.0 - 1.0, nn.xyz * 2.0 - 1.0) < 0.2) ink = 1.0;
+    }
+    FragColor = mix(texture(colorTex, uv), vec4(0.0, 0.0, 0.0, 1.0), ink);
+}
+)";
+
+// ---------- Outline render targets ----------
+struct OutlineTargets { GLuint fbo=0, color=0, normal=0, depth=0; };
+
+static GLuint makeTarget(GLint internalFormat, GLenum format, GLenum type, int w, int h) {
+    GLuint t=0; glGenTextures(1,&t);
+    glBindTexture(GL_TEXTURE_2D, t);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return t;
+}
+
+static OutlineTargets makeOutlineTargets(int w, int h) {
+    OutlineTargets t;
+    t.color  = makeTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, w, h);
+    t.normal = makeTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, w, h);
+    t.depth  = makeTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, w, h);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &t.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, t.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t.color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, t.normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, t.depth, 0);
+    const GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, bufs);
+    check(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "outline framebuffer incomplete");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return t;
+}
+
 // ---------- Math helpers ----------
 static void makePerspective(float fovyDeg, float aspect, float znear, float zfar, float* m) {
     float f = 1.0f / std::tan(fovyDeg * 0.5f * 3.14159265f / 180.0f);
@@ -151,69 +234,98 @@ static void makeTranslate(float x,float y,float z,float* m){ makeIdentity(m); m[
 static void makeRotateY(float a,float* m){ makeIdentity(m); float c=cosf(a),s=sinf(a); m[0]=c; m[2]=s; m[8]=-s; m[10]=c; }
 static void makeScale(float s,float* m){ makeIdentity(m); m[0]=m[5]=m[10]=s; }
 
-// ---------- OBJ loading (legacy tinyobj API) ----------
+// ---------- OBJ loading (tinyobj streaming callbacks) ----------
 struct Vertex { float px,py,pz, nx,ny,nz; };
 
-static bool loadObjExpandTriangles(const std::string& path, std::vector<Vertex>& outVerts) {
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string err;
+// Welding key: vertices are equal when position and normal match bit for bit
+struct VertexHash {
+    size_t operator()(const Vertex& v) const {
+        uint32_t b[6]; std::memcpy(b, &v, sizeof(b));
+        uint64_t h = 1469598103934665603ull; // FNV-1a over the six floats
+        for (uint32_t x : b) h = (h ^ x) * 1099511628211ull;
+        return (size_t)h;
+    }
+};
+struct VertexEq {
+    bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+};
+
+// Positions and normals as tinyobj streams them, welded into outVerts/outIdx as
+// faces arrive. There is no texcoord callback, so those lines go unparsed.
+struct ObjReader {
+    std::vector<float> P, N;
+    std::vector<Vertex>& verts;
+    std::vector<uint32_t>& idx;
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEq> weld;
+
+    ObjReader(std::vector<Vertex>& v, std::vector<uint32_t>& i) : verts(v), idx(i) {}
+
+    void emit(const Vertex& v) {
+        auto it = weld.emplace(v, (uint32_t)verts.size());
+        if (it.second) verts.push_back(v);
+        idx.push_back(it.first->second);
+    }
 
-    bool ok = tinyobj::LoadObj(shapes, materials, err, path.c_str());
-    if (!err.empty()) std::cerr << "[TINYOBJ] " << err << "\n";
-    if (!ok) return false;
+    void triangle(const tinyobj::index_t* corner[3]) {
+        // Files list their vertices before the faces, so by the first face the
+        // count is known (near enough) to size the output
+        if (weld.empty()) {
+            weld.reserve(P.size() / 3);
+            verts.reserve(P.size() / 3);
+        }
+        float p[3][3], n[3][3];
+        bool hasN = true;
+        for (int k = 0; k < 3; k++) {
+            size_t vi = (size_t)corner[k]->vertex_index, ni = (size_t)corner[k]->normal_index;
+            if (corner[k]->vertex_index < 0 || 3*vi + 2 >= P.size()) return;
+            std::memcpy(p[k], &P[3*vi], sizeof(p[k]));
+            if (corner[k]->normal_index >= 0 && 3*ni + 2 < N.size()) std::memcpy(n[k], &N[3*ni], sizeof(n[k]));
+            else hasN = false;
+        }
 
-    outVerts.clear();
+        if (!hasN) {
+            float ux = p[1][0]-p[0][0], uy = p[1][1]-p[0][1], uz = p[1][2]-p[0][2];
+            float vx = p[2][0]-p[0][0], vy = p[2][1]-p[0][1], vz = p[2][2]-p[0][2];
+            float nx = uy*vz - uz*vy;
+            float ny = uz*vx - ux*vz;
+            float nz = ux*vy - uy*vx;
+            float len = std::sqrt(nx*nx + ny*ny + nz*nz); if (len < 1e-8f) len = 1.f;
+            nx/=len; ny/=len; nz/=len;
+            for (int k = 0; k < 3; k++) { n[k][0]=nx; n[k][1]=ny; n[k][2]=nz; }
+        }
 
-    for (const auto& sh : shapes) {
-        const auto& mesh = sh.mesh;
+        for (int k = 0; k < 3; k++) emit({ p[k][0], p[k][1], p[k][2], n[k][0], n[k][1], n[k][2] });
+    }
+};
 
-        const auto& P = mesh.positions;  // xyz packed
-        const auto& N = mesh.normals;    // may be empty
-        const auto& I = mesh.indices;    // triangle indices
+// Triangles as an index buffer over welded (deduplicated) vertices
+static bool loadObjIndexed(const std::string& path, std::vector<Vertex>& outVerts, std::vector<uint32_t>& outIdx) {
+    std::ifstream in(path);
+    if (!in) { std::cerr << "[TINYOBJ] Cannot open file [" << path << "]\n"; return false; }
 
-        if (I.size() % 3 != 0) {
-            std::cerr << "[TINYOBJ] indices not divisible by 3; got " << I.size() << "\n";
+    outVerts.clear();
+    outIdx.clear();
+    ObjReader reader(outVerts, outIdx);
+
+    tinyobj::callback_t cb;
+    cb.vertex_cb = [](void* user, float x, float y, float z) {
+        auto& P = ((ObjReader*)user)->P; P.push_back(x); P.push_back(y); P.push_back(z);
+    };
+    cb.normal_cb = [](void* user, float x, float y, float z) {
+        auto& N = ((ObjReader*)user)->N; N.push_back(x); N.push_back(y); N.push_back(z);
+    };
+    // Polygons as triangle fans, like LoadObj
+    cb.index_cb = [](void* user, const tinyobj::index_t* face, int count) {
+        for (int k = 2; k < count; k++) {
+            const tinyobj::index_t* corner[3] = { &face[0], &face[k-1], &face[k] };
+            ((ObjReader*)user)->triangle(corner);
         }
+    };
 
-        for (size_t i = 0; i + 2 < I.size(); i += 3) {
-            unsigned int ia = I[i+0];
-            unsigned int ib = I[i+1];
-            unsigned int ic = I[i+2];
-
-            auto getP = [&](unsigned int idx, float out[3]) {
-                out[0] = P[3*idx + 0];
-                out[1] = P[3*idx + 1];
-                out[2] = P[3*idx + 2];
-            };
-            auto getN = [&](unsigned int idx, float out[3]) -> bool {
-                if (N.empty()) return false;
-                out[0] = N[3*idx + 0];
-                out[1] = N[3*idx + 1];
-                out[2] = N[3*idx + 2];
-                return true;
-            };
-
-            float pa[3], pb[3], pc[3]; getP(ia, pa); getP(ib, pb); getP(ic, pc);
-            float na[3], nb[3], nc[3];
-            bool hasNa = getN(ia, na), hasNb = getN(ib, nb), hasNc = getN(ic, nc);
-
-            if (!hasNa || !hasNb || !hasNc) {
-                float ux = pb[0]-pa[0], uy = pb[1]-pa[1], uz = pb[2]-pa[2];
-                float vx = pc[0]-pa[0], vy = pc[1]-pa[1], vz = pc[2]-pa[2];
-                float nx = uy*vz - uz*vy;
-                float ny = uz*vx - ux*vz;
-                float nz = ux*vy - uy*vx;
-                float len = std::sqrt(nx*nx + ny*ny + nz*nz); if (len < 1e-8f) len = 1.f;
-                nx/=len; ny/=len; nz/=len;
-                na[0]=nb[0]=nc[0]=nx; na[1]=nb[1]=nc[1]=ny; na[2]=nb[2]=nc[2]=nz;
-            }
-
-            outVerts.push_back({ pa[0], pa[1], pa[2], na[0], na[1], na[2] });
-            outVerts.push_back({ pb[0], pb[1], pb[2], nb[0], nb[1], nb[2] });
-            outVerts.push_back({ pc[0], pc[1], pc[2], nc[0], nc[1], nc[2] });
-        }
-    }
+    std::string err;
+    bool ok = tinyobj::LoadObjWithCallback(in, cb, &reader, nullptr, err);
+    if (!err.empty()) std::cerr << "[TINYOBJ] " << err << "\n";
+    if (!ok) return false;
 
     // Normalize to unit-ish size
     float minx=1e30f,miny=1e30f,minz=1e30f, maxx=-1e30f,maxy=-1e30f,maxz=-1e30f;
@@ -238,6 +350,11 @@ static bool loadObjExpandTriangles(const std::string& path, std::vector<Vertex>&
 static float gYaw = 0.0f;     // radians, Y rotation (A/D)
 static float gDist = -3.2f;   // camera distance along -Z (W/S moves this toward/away)
 static double gPrevTime = 0.0;
+static bool gScreenOutline = false; // O toggles screen-space vs. inflated-hull outline
+
+static void keyCallback(GLFWwindow*, int key, int, int action, int) {
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) gScreenOutline = !gScreenOutline;
+}
 
 static void handleInput(GLFWwindow* win) {
     double now = glfwGetTime();
@@ -261,9 +378,12 @@ static void handleInput(GLFWwindow* win) {
 int main(int argc, char** argv) {
     const char* objPath = (argc >= 2) ? argv[1] : nullptr;
     if (!objPath) {
-        std::cerr << "Usage: " << argv[0] << " path/to/model.obj\n";
+        std::cerr << "Usage: " << argv[0] << " path/to/model.obj [--screen-outline]\n";
         return EXIT_FAILURE;
     }
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) == "--screen-outline") gScreenOutline = true;
+    }
 
     check(glfwInit(), "glfwInit failed");
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
@@ -276,6 +396,7 @@ int main(int argc, char** argv) {
     check(win, "glfwCreateWindow failed");
     glfwMakeContextCurrent(win);
     glfwSwapInterval(1);
+    glfwSetKeyCallback(win, keyCallback);
 
     check(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress), "gladLoadGLLoader failed");
     glEnable(GL_DEPTH_TEST);
@@ -302,19 +423,34 @@ int main(int argc, char** argv) {
     GLint uP_out = glGetUniformLocation(pOutline, "P");
     GLint uS_out = glGetUniformLocation(pOutline, "outlineScale");
 
+    // Screen-space outline program (samplers on units 0-2)
+    GLuint pEdge    = linkProgram({ compile(GL_VERTEX_SHADER,   edgeVS),
+                                    compile(GL_FRAGMENT_SHADER, edgeFS) });
+    GLint uP_edge    = glGetUniformLocation(pEdge, "P");
+    GLint uStep_edge = glGetUniformLocation(pEdge, "texelStep");
+    glUseProgram(pEdge);
+    glUniform1i(glGetUniformLocation(pEdge, "colorTex"),  0);
+    glUniform1i(glGetUniformLocation(pEdge, "normalTex"), 1);
+    glUniform1i(glGetUniformLocation(pEdge, "depthTex"),  2);
+    glUseProgram(0);
+
     // Load OBJ
     std::vector<Vertex> verts;
-    if (!loadObjExpandTriangles(objPath, verts)) {
+    std::vector<uint32_t> indices;
+    if (!loadObjIndexed(objPath, verts, indices)) {
         std::cerr << "Failed to load OBJ: " << objPath << "\n";
         return EXIT_FAILURE;
     }
-    std::cout << "Loaded triangles: " << (verts.size()/3) << " (verts: " << verts.size() << ")\n";
+    std::cout << "Loaded triangles: " << (indices.size()/3) << " (verts: " << verts.size()
+              << " welded from " << indices.size() << ")\n";
 
-    // Create VAO/VBO
-    GLuint vao=0,vbo=0; glGenVertexArrays(1,&vao); glGenBuffers(1,&vbo);
+    // Create VAO/VBO/EBO
+    GLuint vao=0,vbo=0,ebo=0; glGenVertexArrays(1,&vao); glGenBuffers(1,&vbo); glGenBuffers(1,&ebo);
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, verts.size()*sizeof(Vertex), verts.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)0);
     glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)(3*sizeof(float)));
     glBindVertexArray(0);
@@ -323,6 +459,11 @@ int main(int argc, char** argv) {
     int w=900,h=700;
     float P[16]; makePerspective(60.0f, float(w)/float(h), 0.05f, 100.0f, P);
 
+    // Outline FBO (the window is not resizable, so it is allocated once)
+    OutlineTargets outlineFB = makeOutlineTargets(w, h);
+    GLuint emptyVao=0; glGenVertexArrays(1,&emptyVao); // fullscreen triangle needs a bound VAO
+    const float outlinePx = 1.5f;
+
     // Material defaults
     const float amb[3]  = {0.15f, 0.15f, 0.15f};
     const float dif[3]  = {0.80f, 0.65f, 0.20f};
@@ -338,7 +479,15 @@ int main(int argc, char** argv) {
 
         glViewport(0,0,w,h);
         glClearColor(0.08f,0.1f,0.14f,1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (gScreenOutline) {
+            // Render the cel pass into the FBO; normal alpha 0 marks background
+            const GLfloat noNormal[4] = {0.5f, 0.5f, 1.0f, 0.0f};
+            glBindFramebuffer(GL_FRAMEBUFFER, outlineFB.fbo);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glClearBufferfv(GL_COLOR, 1, noNormal);
+        } else {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
         // Model/View: rotate by yaw and position camera at gDist on -Z
         float T[16], R[16], S[16], M[16], V[16], TR[16];
@@ -348,19 +497,21 @@ int main(int argc, char** argv) {
         mult(T,R,TR); mult(TR,S,M);
         makeIdentity(V);
 
-        // --- 1) Outline pass: backfaces, slightly inflated
+        // --- 1) Outline pass: backfaces, slightly inflated (skipped in screen-space mode)
         glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);
-
-        glUseProgram(pOutline);
-        glUniformMatrix4fv(uM_out,1,GL_FALSE,M);
-        glUniformMatrix4fv(uV_out,1,GL_FALSE,V);
-        glUniformMatrix4fv(uP_out,1,GL_FALSE,P);
-        glUniform1f(uS_out, 0.02f); // outline thickness (0.01–0.03 typical)
-
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verts.size());
-        glBindVertexArray(0);
+        if (!gScreenOutline) {
+            glCullFace(GL_FRONT);
+
+            glUseProgram(pOutline);
+            glUniformMatrix4fv(uM_out,1,GL_FALSE,M);
+            glUniformMatrix4fv(uV_out,1,GL_FALSE,V);
+            glUniformMatrix4fv(uP_out,1,GL_FALSE,P);
+            glUniform1f(uS_out, 0.02f); // outline thickness (0.01–0.03 typical)
+
+            glBindVertexArray(vao);
+            glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
+            glBindVertexArray(0);
+        }
 
         glCullFace(GL_BACK); // restore
 
@@ -376,18 +527,41 @@ int main(int argc, char** argv) {
         glUniform1f(uShine, shine);
 
         glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verts.size());
+        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
         glBindVertexArray(0);
 
         glDisable(GL_CULL_FACE);
 
+        // --- 3) Screen-space outline: ink edges while copying to the window
+        if (gScreenOutline) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDisable(GL_DEPTH_TEST);
+            glUseProgram(pEdge);
+            glUniformMatrix4fv(uP_edge,1,GL_FALSE,P);
+            glUniform2f(uStep_edge, outlinePx/w, outlinePx/h);
+            glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D, outlineFB.color);
+            glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D, outlineFB.normal);
+            glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D, outlineFB.depth);
+            glBindVertexArray(emptyVao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            glActiveTexture(GL_TEXTURE0);
+            glEnable(GL_DEPTH_TEST);
+        }
+
         glfwSwapBuffers(win);
     }
 
     glDeleteVertexArrays(1,&vao);
     glDeleteBuffers(1,&vbo);
+    glDeleteBuffers(1,&ebo);
     glDeleteProgram(pOutline);
     glDeleteProgram(pCel);
+    glDeleteProgram(pEdge);
+    glDeleteVertexArrays(1,&emptyVao);
+    glDeleteFramebuffers(1,&outlineFB.fbo);
+    const GLuint targets[3] = { outlineFB.color, outlineFB.normal, outlineFB.depth };
+    glDeleteTextures(3, targets);
     glfwTerminate();
     return 0;
 }
@@ -0,0 +1,165 @@
+// Round-trip check of tinyobj's number parser (tryParseDouble, and parseFloat
+// on top of it) against strtod: edge tokens, sampled floats (%.9g) and doubles
+// (%.17g, %.15g, %.6f) and random decimal strings must give the same bits.
+//
+//   ParseNumberTest               sampled (run by ctest)
+//   ParseNumberTest --exhaustive  every finite float (about an hour)
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// The parser is internal to the implementation, so the test compiles its own copy
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader/tiny_obj_loader.h>
+
+using namespace std;
+
+
+static uint64_t checked = 0;
+static uint64_t failures = 0;
+
+static uint64_t bitsOf(double d)
+{
+	uint64_t b;
+	memcpy(&b, &d, sizeof(b));
+	return b;
+}
+
+// Compares with strtod; a token strtod cannot read must be rejected
+static void check(const char *token)
+{
+	char *expectEnd = nullptr;
+	double expect = strtod(token, &expectEnd);
+	double got = -1.0;
+	bool parsed = tinyobj::tryParseDouble(token, token + strlen(token), &got);
+	bool ok = expectEnd == token ? !parsed : parsed && bitsOf(got) == bitsOf(expect);
+	checked++;
+	if (!ok && ++failures <= 20)
+	{
+		printf("MISMATCH \"%s\": got %.17g%s, strtod %.17g\n", token, got, parsed ? "" : " (rejected)", expect);
+	}
+}
+
+static void checkFloat(uint32_t b)
+{
+	float f;
+	memcpy(&f, &b, sizeof(f));
+	// NaN and infinities are not OBJ numbers
+	if (f != f || f - f != 0.0f)
+	{
+		return;
+	}
+	char s[64];
+	snprintf(s, sizeof(s), "%.9g", double(f));
+	check(s);
+
+	// %.9g is enough for the float to come back through parseFloat unchanged
+	const char *token = s;
+	float back = tinyobj::parseFloat(token);
+	uint32_t backBits;
+	memcpy(&backBits, &back, sizeof(backBits));
+	if (backBits != b && ++failures <= 20)
+	{
+		printf("ROUND TRIP %08x -> \"%s\" -> %08x\n", unsigned(b), s, unsigned(backBits));
+	}
+}
+
+static uint64_t xorshift(uint64_t &s)
+{
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--exhaustive") == 0)
+	{
+		for (uint64_t b = 0; b <= 0xFFFFFFFFull; b++)
+		{
+			checkFloat(uint32_t(b));
+		}
+		printf("exhaustive: %llu tokens, %llu failures\n", (unsigned long long)checked, (unsigned long long)failures);
+		return failures ? 1 : 0;
+	}
+
+	static const char *edges[] = {
+		"0", "-0", "+0", "0.0", "-0.0", "00", "0e0", "-0e-5", ".5", "-.5", "+.5e-3", "5.", "5.e2", "1e", "1e+", "1E-", "1.5e", "1.5ex", "2e3x",
+		"1e22", "1e23", "-1e-22", "1e-23", "9007199254740992", "9007199254740993", "-9007199254740993e-5", "18446744073709551615",
+		"18446744073709551616", "123456789012345678901234567890", "0.123456789012345678901234567890", "12345678901234567890.5",
+		"3.14159265358979323846264338327950288", "00000000000000000000000001.25", "0.00000000000000000000000000000000000001",
+		"1e308", "-1e308", "1.7976931348623157e308", "1.7976931348623159e308", "1e309", "-1e309", "1e-308", "2.2250738585072014e-308",
+		"4.9406564584124654e-324", "2.4703282292062328e-324", "1e-324", "1e-400", "1e99999999999", "1e-99999999999",
+		"0.000000000000000000000000000000001e33", "100000000000000000000000e-23", "7.038531e-26", "1.17549435e-38", "3.40282347e38",
+		".", "-", ".e1", "+.e1", "e5", "-e5", "abc", "",
+	};
+	for (const char *token : edges)
+	{
+		check(token);
+	}
+	uint64_t edgeCount = checked;
+
+	// Floats across every exponent, with a stride that reaches all mantissa bit positions
+	for (uint64_t b = 0; b <= 0xFFFFFFFFull; b += 997)
+	{
+		checkFloat(uint32_t(b));
+	}
+	uint64_t floatCount = checked - edgeCount;
+
+	uint64_t seed = 0x9E3779B97F4A7C15ull;
+	static const char *formats[] = {"%.17g", "%.15g", "%.6f"};
+	for (int i = 0; i < 300000; i++)
+	{
+		uint64_t b = xorshift(seed);
+		double d;
+		memcpy(&d, &b, sizeof(d));
+		if (d != d || d - d != 0.0)
+		{
+			continue;
+		}
+		// %.6f of large values runs to hundreds of digits, which only strtod can round
+		char s[512];
+		for (const char *format : formats)
+		{
+			snprintf(s, sizeof(s), format, d);
+			check(s);
+		}
+	}
+
+	// Decimal strings as exporters and hand edits write them: short and long
+	// mantissas, leading zeros, optional point and exponent
+	for (int i = 0; i < 300000; i++)
+	{
+		char s[64];
+		int n = 0;
+		uint64_t r = xorshift(seed);
+		if (r & 1)
+		{
+			s[n++] = (r & 2) ? '-' : '+';
+		}
+		int digits = 1 + int((r >> 2) % 25);
+		int point = int((r >> 8) % (digits + 1));
+		for (int k = 0; k < digits; k++)
+		{
+			if (k == point && ((r >> 13) & 1))
+			{
+				s[n++] = '.';
+			}
+			s[n++] = char('0' + xorshift(seed) % 10);
+		}
+		if ((r >> 14) & 1)
+		{
+			n += snprintf(s + n, sizeof(s) - size_t(n), "e%d", int((r >> 16) % 80) - 40);
+		}
+		s[n] = '\0';
+		check(s);
+	}
+
+	printf("%llu edge tokens, %llu sampled floats, %llu doubles and decimal strings: %llu failures\n",
+		(unsigned long long)edgeCount, (unsigned long long)floatCount,
+		(unsigned long long)(checked - edgeCount - floatCount), (unsigned long long)failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+// Cost per numeric token of tinyobj's tryParseDouble next to strtod and atof
+// (parseFloat with TINY_OBJ_LOADER_OLD_FLOAT_PARSER), over the vertex
+// coordinates of OBJ files, plus the time of a whole LoadObj.
+//
+//   ParseNumberBench file.obj [file.obj ...]
+//
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The parser is internal to the implementation, so the benchmark compiles its own copy
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader/tiny_obj_loader.h>
+
+using namespace std;
+
+
+// Best of three rounds, each at least 0.2 s, in ns per token
+template <typename F>
+static double nsPerToken(size_t count, F body)
+{
+	double best = 1e30;
+	for (int round = 0; round < 3; round++)
+	{
+		size_t runs = 0;
+		double ns = 0;
+		auto start = chrono::steady_clock::now();
+		do
+		{
+			body();
+			runs++;
+			ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+		} while (ns < 2e8);
+		best = min(best, ns / double(runs * count));
+	}
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s file.obj [file.obj ...]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%-28s %9s %14s %9s %9s %11s\n", "file", "tokens", "tryParseDouble", "strtod", "atof", "LoadObj (ms)");
+	for (int f = 1; f < argc; f++)
+	{
+		ifstream in(argv[f], ios::binary);
+		if (!in)
+		{
+			fprintf(stderr, "cannot open %s\n", argv[f]);
+			return 1;
+		}
+		stringstream text;
+		text << in.rdbuf();
+
+		// The three coordinates of every "v" line, each NUL-terminated for strtod
+		string tokens;
+		vector<size_t> starts;
+		string line;
+		while (getline(text, line))
+		{
+			istringstream words(line);
+			string head, coord;
+			if (!(words >> head) || head != "v")
+			{
+				continue;
+			}
+			for (int k = 0; k < 3 && (words >> coord); k++)
+			{
+				starts.push_back(tokens.size());
+				tokens += coord;
+				tokens += '\0';
+			}
+		}
+		if (starts.empty())
+		{
+			fprintf(stderr, "%s has no vertices\n", argv[f]);
+			continue;
+		}
+		const char *base = tokens.data();
+
+		volatile double sink = 0;
+		double fast = nsPerToken(starts.size(), [&] {
+			double sum = 0, v = 0;
+			for (size_t s : starts)
+			{
+				const char *t = base + s;
+				tinyobj::tryParseDouble(t, t + strlen(t), &v);
+				sum += v;
+			}
+			sink = sum;
+		});
+		double libc = nsPerToken(starts.size(), [&] {
+			double sum = 0;
+			for (size_t s : starts)
+			{
+				sum += strtod(base + s, nullptr);
+			}
+			sink = sum;
+		});
+		double old = nsPerToken(starts.size(), [&] {
+			double sum = 0;
+			for (size_t s : starts)
+			{
+				sum += atof(base + s);
+			}
+			sink = sum;
+		});
+
+		// Every token must agree with strtod bit for bit
+		size_t mismatches = 0;
+		for (size_t s : starts)
+		{
+			const char *t = base + s;
+			double v = 0;
+			tinyobj::tryParseDouble(t, t + strlen(t), &v);
+			double expect = strtod(t, nullptr);
+			if (memcmp(&v, &expect, sizeof(v)) != 0)
+			{
+				mismatches++;
+			}
+		}
+
+		double load = 1e30;
+		for (int round = 0; round < 3; round++)
+		{
+			vector<tinyobj::shape_t> shapes;
+			vector<tinyobj::material_t> materials;
+			string err;
+			auto start = chrono::steady_clock::now();
+			tinyobj::LoadObj(shapes, materials, err, argv[f]);
+			load = min(load, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+		}
+
+		string name = argv[f];
+		name = name.substr(name.find_last_of("/\\") + 1);
+		printf("%-28s %9zu %11.1f ns %6.1f ns %6.1f ns %11.2f%s\n", name.c_str(), starts.size(), fast, libc, old, load,
+			mismatches ? "  MISMATCH" : "");
+		if (mismatches)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
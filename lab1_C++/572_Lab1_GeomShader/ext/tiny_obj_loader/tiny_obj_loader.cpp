@@ -5,12 +5,31 @@
 #include <cmath>
 #include <cstddef>
 #include <cctype>
+#include <stdint.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "tiny_obj_loader.h"
 
@@ -27,17 +46,172 @@ struct vertex_index {
   vertex_index(int vidx, int vtidx, int vnidx)
       : v_idx(vidx), vt_idx(vtidx), vn_idx(vnidx){}
 };
-// for std::map
-static inline bool operator<(const vertex_index &a, const vertex_index &b) {
-  if (a.v_idx != b.v_idx)
-    return (a.v_idx < b.v_idx);
-  if (a.vn_idx != b.vn_idx)
-    return (a.vn_idx < b.vn_idx);
-  if (a.vt_idx != b.vt_idx)
-    return (a.vt_idx < b.vt_idx);
-
-  return false;
-}
+
+// Open-addressing hash table from a (v, vt, vn) triple to the index of the
+// vertex it became, used to share vertices between faces. reset() sizes it
+// for a face group's corner count (the most vertices the group can make), so
+// it never grows while filling and stays under 2/3 full.
+class vertex_cache {
+public:
+  vertex_cache() : mask(0) {}
+
+  void reset(size_t max_vertices) {
+    size_t capacity = 16;
+    while (capacity < max_vertices + max_vertices / 2) {
+      capacity *= 2;
+    }
+    slot empty;
+    empty.key = vertex_index(-1);
+    empty.value = kEmpty;
+    slots.assign(capacity, empty);
+    mask = capacity - 1;
+  }
+
+  // Returns the slot for i; a new slot's value is kEmpty, to be filled by the caller
+  unsigned int &lookup(const vertex_index &i) {
+    size_t h = hash(i) & mask;
+    while (slots[h].value != kEmpty &&
+           (slots[h].key.v_idx != i.v_idx || slots[h].key.vt_idx != i.vt_idx ||
+            slots[h].key.vn_idx != i.vn_idx)) {
+      h = (h + 1) & mask;
+    }
+    if (slots[h].value == kEmpty) {
+      slots[h].key = i;
+    }
+    return slots[h].value;
+  }
+
+  static const unsigned int kEmpty = 0xffffffffu;
+
+private:
+  struct slot {
+    vertex_index key;
+    unsigned int value;
+  };
+
+  // The three indices packed into 64 bits and mixed (murmur3 finalizer)
+  static size_t hash(const vertex_index &i) {
+    uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(i.v_idx)) << 32) ^
+                 (static_cast<uint64_t>(static_cast<uint32_t>(i.vt_idx)) << 16) ^
+                 static_cast<uint64_t>(static_cast<uint32_t>(i.vn_idx));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  std::vector<slot> slots;
+  size_t mask;
+};
+
+// The faces of a group as flat arrays: every face's corners back to back in
+// indices, and how many corners each face has in face_vertex_counts.
+// clear() keeps the capacity, so the arrays stop growing after the largest group.
+struct face_group {
+  std::vector<vertex_index> indices;
+  std::vector<int> face_vertex_counts;
+  size_t triangles;
+
+  face_group() : triangles(0) {}
+
+  // A position in the arrays
+  struct mark {
+    size_t faces, corners, triangles;
+    mark() : faces(0), corners(0), triangles(0) {}
+  };
+
+  bool empty() const { return face_vertex_counts.empty(); }
+
+  mark tell() const {
+    mark m;
+    m.faces = face_vertex_counts.size();
+    m.corners = indices.size();
+    m.triangles = triangles;
+    return m;
+  }
+
+  // Appends the faces of other between two of its marks
+  void append(const face_group &other, const mark &from, const mark &to) {
+    indices.insert(indices.end(), other.indices.begin() + from.corners,
+                   other.indices.begin() + to.corners);
+    face_vertex_counts.insert(face_vertex_counts.end(),
+                              other.face_vertex_counts.begin() + from.faces,
+                              other.face_vertex_counts.begin() + to.faces);
+    triangles += to.triangles - from.triangles;
+  }
+
+  void clear() {
+    indices.clear();
+    face_vertex_counts.clear();
+    triangles = 0;
+  }
+};
+
+// Hands out the lines of a stream as NUL-terminated views into one read
+// buffer (the '\n' or "\r\n" is overwritten), so reading a line neither copies
+// nor allocates. The buffer grows only for a line longer than itself.
+class line_reader {
+public:
+  explicit line_reader(std::istream &in)
+      : in(in), buf(65536), begin(0), end(0), eof(false) {}
+
+  // Returns the next line, or NULL at the end of the stream
+  char *next() {
+    for (;;) {
+      char *line = &buf[begin];
+      char *newline = static_cast<char *>(memchr(line, '\n', end - begin));
+      if (newline) {
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') {
+          newline[-1] = '\0';
+        }
+        begin = static_cast<size_t>(newline - &buf[0]) + 1;
+        return line;
+      }
+      if (eof) {
+        if (begin == end) {
+          return NULL;
+        }
+        // Last line without a newline; fill() always leaves room for the NUL
+        buf[end] = '\0';
+        if (buf[end - 1] == '\r') {
+          buf[end - 1] = '\0';
+        }
+        begin = end;
+        return line;
+      }
+      fill();
+    }
+  }
+
+private:
+  // Moves the partial line to the front and reads more after it
+  void fill() {
+    size_t partial = end - begin;
+    if (begin > 0) {
+      memmove(&buf[0], &buf[begin], partial);
+      begin = 0;
+      end = partial;
+    }
+    if (end + 1 >= buf.size()) {
+      buf.resize(buf.size() * 2);
+    }
+    in.read(&buf[end], static_cast<std::streamsize>(buf.size() - 1 - end));
+    std::streamsize got = in.gcount();
+    end += static_cast<size_t>(got);
+    if (got == 0 || !in) {
+      eof = true;
+    }
+  }
+
+  std::istream &in;
+  std::vector<char> buf;
+  size_t begin;
+  size_t end;
+  bool eof;
+};
 
 struct obj_shape {
   std::vector<float> v;
@@ -47,6 +221,8 @@ struct obj_shape {
 
 static inline bool isSpace(const char c) { return (c == ' ') || (c == '\t'); }
 
+// Lines may end in '\n' rather than '\0' (LoadObjParallel parses them in
+// place), so token scans stop at either.
 static inline bool isNewLine(const char c) {
   return (c == '\r') || (c == '\n') || (c == '\0');
 }
@@ -75,6 +251,55 @@ static inline int parseInt(const char *&token) {
 }
 
 
+// Eight ASCII digits at a time (SWAR): p must have 8 readable bytes. The
+// bytes are read little-endian, as on every platform the labs build for.
+static inline uint64_t loadEight(const char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline bool isEightDigits(uint64_t v) {
+  return (((v & 0xF0F0F0F0F0F0F0F0ull) |
+           (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+          0x3333333333333333ull);
+}
+
+static inline uint64_t parseEightDigits(uint64_t v) {
+  const uint64_t mask = 0x000000FF000000FFull;
+  const uint64_t mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+  v -= 0x3030303030303030ull;
+  v = (v * 10) + (v >> 8);
+  v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+  return v;
+}
+
+// Reads digits into mantissa while it can hold them (19 digits); later
+// digits only count in dropped.
+static inline const char *scanDigits(const char *p, const char *s_end,
+                                     uint64_t &mantissa, int &digits,
+                                     int &dropped) {
+  while (s_end - p >= 8 && digits <= 11) {
+    uint64_t v = loadEight(p);
+    if (!isEightDigits(v)) {
+      break;
+    }
+    mantissa = mantissa * 100000000 + parseEightDigits(v);
+    digits += 8;
+    p += 8;
+  }
+  for (; p != s_end && static_cast<unsigned>(*p - '0') < 10; p++) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+      digits++;
+    } else {
+      dropped++;
+    }
+  }
+  return p;
+}
+
 // Tries to parse a floating point number located at s.
 //
 // s_end should be a location in the string where reading should absolutely
@@ -84,146 +309,137 @@ static inline int parseInt(const char *&token) {
 //   sign    = "+" | "-" ;
 //   END     = ? anything not in digit ?
 //   digit   = "0" | "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9" ;
-//   integer = [sign] , digit , {digit} ;
-//   decimal = integer , ["." , integer] ;
-//   float   = ( decimal , END ) | ( decimal , ("E" | "e") , integer , END ) ;
+//   digits  = digit , {digit} ;
+//   decimal = [sign] , ( digits , ["." , {digit}] | "." , digits ) ;
+//   float   = ( decimal , END ) | ( decimal , ("E" | "e") , [sign] , digits , END ) ;
 //
 //  Valid strings are for example:
-//   -0  +3.1417e+2  -0.0E-3  1.0324  -1.41   11e2
+//   -0  +3.1417e+2  -0.0E-3  1.0324  -1.41   11e2  .5
 //
-// If the parsing is a success, result is set to the parsed value and true 
-// is returned.
+// If the parsing is a success, result is set to the correctly rounded
+// double (as strtod would give) and true is returned.
 //
 // The function is greedy and will parse until any of the following happens:
 //  - a non-conforming character is encountered.
 //  - s_end is reached.
 //
+// A mantissa of at most 2^53 (any 15 significant digits, most 16-digit ones)
+// with a power of ten within 1e22 - every coordinate an exporter writes - is
+// exact in double arithmetic (Clinger's fast path): one multiply or divide of
+// the integer mantissa. Anything else, longer mantissas included, is handed
+// to strtod.
+//
 // The following situations triggers a failure:
 //  - s >= s_end.
 //  - parse failure.
-// 
+//
 static bool tryParseDouble(const char *s, const char *s_end, double *result)
 {
-    if (s >= s_end)
-    {
-        return false;
-    }
+  static const double kPow10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
 
-    double mantissa = 0.0;
-    // This exponent is base 2 rather than 10.
-    // However the exponent we parse is supposed to be one of ten,
-    // thus we must take care to convert the exponent/and or the 
-    // mantissa to a * 2^E, where a is the mantissa and E is the
-    // exponent.
-    // To get the final double we will use ldexp, it requires the
-    // exponent to be in base 2.
-    int exponent = 0;
-
-    // NOTE: THESE MUST BE DECLARED HERE SINCE WE ARE NOT ALLOWED
-    // TO JUMP OVER DEFINITIONS.
-    char sign = '+';
-    char exp_sign = '+';
-    char const *curr = s;
-
-    // How many characters were read in a loop. 
-    int read = 0;
-    // Tells whether a loop terminated due to reaching s_end.
-    bool end_not_reached = false;
-
-    /*
-        BEGIN PARSING.
-    */
-
-    // Find out what sign we've got.
-    if (*curr == '+' || *curr == '-')
-    {
-        sign = *curr;
-        curr++;
-    }
-    else if (isdigit(*curr)) { /* Pass through. */ }
-    else
-    {
-        goto fail;
-    }
+  if (s >= s_end) {
+    return false;
+  }
 
-    // Read the integer part.
-    while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-    {
-        mantissa *= 10;
-        mantissa += static_cast<int>(*curr - 0x30);
-        curr++; read++;
-    }
+  const char *curr = s;
+  bool negative = false;
+  if (*curr == '+' || *curr == '-') {
+    negative = *curr == '-';
+    curr++;
+  }
 
-    // We must make sure we actually got something.
-    if (read == 0)
-        goto fail;
-    // We allow numbers of form "#", "###" etc.
-    if (!end_not_reached)
-        goto assemble;
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int dropped = 0;
 
-    // Read the decimal part.
-    if (*curr == '.')
-    {
+  // Leading zeros do not take up mantissa digits.
+  const char *first = curr;
+  while (curr != s_end && *curr == '0') {
+    curr++;
+  }
+  bool any = curr != first;
+
+  const char *int_start = curr;
+  curr = scanDigits(curr, s_end, mantissa, digits, dropped);
+  any = any || curr != int_start;
+  // Integer digits that did not fit still scale the value.
+  int exponent = dropped;
+
+  if (curr != s_end && *curr == '.') {
+    curr++;
+    const char *frac_start = curr;
+    if (mantissa == 0) {
+      while (curr != s_end && *curr == '0') {
         curr++;
-        read = 1;
-        while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-        {
-            // NOTE: Don't use powf here, it will absolutely murder precision.
-            mantissa += static_cast<int>(*curr - 0x30) * pow(10.0, -read);
-            read++; curr++;
-        }
-    }
-    else if (*curr == 'e' || *curr == 'E') {}
-    else
-    {
-        goto assemble;
+      }
+      exponent -= static_cast<int>(curr - frac_start);
     }
+    int before = digits;
+    curr = scanDigits(curr, s_end, mantissa, digits, dropped);
+    exponent -= digits - before;
+    any = any || curr != frac_start;
+  }
 
-    if (!end_not_reached)
-        goto assemble;
-
-    // Read the exponent part.
-    if (*curr == 'e' || *curr == 'E')
-    {
-        curr++;
-        // Figure out if a sign is present and if it is.
-        if ((end_not_reached = (curr != s_end)) && (*curr == '+' || *curr == '-'))
-        {
-            exp_sign = *curr;
-            curr++;
-        }
-        else if (isdigit(*curr)) { /* Pass through. */ }
-        else
-        {
-            // Empty E is not allowed.
-            goto fail;
-        }
+  if (!any) {
+    return false;
+  }
 
-        read = 0;
-        while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-        {
-            exponent *= 10;
-            exponent += static_cast<int>(*curr - 0x30);
-            curr++; read++;
+  // An 'e' without digits after it is not part of the number.
+  if (curr != s_end && (*curr == 'e' || *curr == 'E')) {
+    const char *e = curr + 1;
+    bool exp_negative = false;
+    if (e != s_end && (*e == '+' || *e == '-')) {
+      exp_negative = *e == '-';
+      e++;
+    }
+    if (e != s_end && static_cast<unsigned>(*e - '0') < 10) {
+      int exp_value = 0;
+      for (; e != s_end && static_cast<unsigned>(*e - '0') < 10; e++) {
+        if (exp_value < 100000) {
+          exp_value = exp_value * 10 + (*e - '0');
         }
-        exponent *= (exp_sign == '+'? 1 : -1);
-        if (read == 0)
-            goto fail;
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+      curr = e;
     }
+  }
 
-assemble:
-    *result = (sign == '+'? 1 : -1) * ldexp(mantissa * pow(5.0, exponent), exponent);
+  double value;
+  if (mantissa == 0) {
+    value = 0.0;
+  } else if (dropped == 0 && mantissa <= (1ull << 53) && exponent >= -22 &&
+             exponent <= 22) {
+    value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+  } else {
+    // Rare: too many digits or a huge exponent. strtod reads the same span.
+    char buf[64];
+    std::string longer;
+    size_t length = static_cast<size_t>(curr - s);
+    const char *text = buf;
+    if (length < sizeof(buf)) {
+      memcpy(buf, s, length);
+      buf[length] = '\0';
+    } else {
+      longer.assign(s, curr);
+      text = longer.c_str();
+    }
+    *result = strtod(text, NULL);
     return true;
-fail:
-    return false;
+  }
+
+  *result = negative ? -value : value;
+  return true;
 }
 static inline float parseFloat(const char *&token) {
   token += strspn(token, " \t");
 #ifdef TINY_OBJ_LOADER_OLD_FLOAT_PARSER
   float f = (float)atof(token);
-  token += strcspn(token, " \t\r");
+  token += strcspn(token, " \t\r\n");
 #else
-  const char *end = token + strcspn(token, " \t\r");
+  const char *end = token + strcspn(token, " \t\r\n");
   double val = 0.0;
   tryParseDouble(token, end, &val);
   float f = static_cast<float>(val);
@@ -245,13 +461,28 @@ static inline void parseFloat3(float &x, float &y, float &z,
   z = parseFloat(token);
 }
 
+// atoi without its whitespace skipping, which could run onto the next line
+static inline int parseIndex(const char *token) {
+  bool negative = false;
+  if (*token == '+' || *token == '-') {
+    negative = *token == '-';
+    token++;
+  }
+  int i = 0;
+  while (*token >= '0' && *token <= '9') {
+    i = i * 10 + (*token - '0');
+    token++;
+  }
+  return negative ? -i : i;
+}
+
 // Parse triples: i, i/j/k, i//k, i/j
 static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
                                 int vtsize) {
   vertex_index vi(-1);
 
-  vi.v_idx = fixIndex(atoi(token), vsize);
-  token += strcspn(token, "/ \t\r");
+  vi.v_idx = fixIndex(parseIndex(token), vsize);
+  token += strcspn(token, "/ \t\r\n");
   if (token[0] != '/') {
     return vi;
   }
@@ -260,37 +491,37 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
   // i//k
   if (token[0] == '/') {
     token++;
-    vi.vn_idx = fixIndex(atoi(token), vnsize);
-    token += strcspn(token, "/ \t\r");
+    vi.vn_idx = fixIndex(parseIndex(token), vnsize);
+    token += strcspn(token, "/ \t\r\n");
     return vi;
   }
 
   // i/j/k or i/j
-  vi.vt_idx = fixIndex(atoi(token), vtsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vt_idx = fixIndex(parseIndex(token), vtsize);
+  token += strcspn(token, "/ \t\r\n");
   if (token[0] != '/') {
     return vi;
   }
 
   // i/j/k
   token++; // skip '/'
-  vi.vn_idx = fixIndex(atoi(token), vnsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vn_idx = fixIndex(parseIndex(token), vnsize);
+  token += strcspn(token, "/ \t\r\n");
   return vi;
 }
 
 static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
+updateVertex(vertex_cache &vertexCache,
              std::vector<float> &positions, std::vector<float> &normals,
              std::vector<float> &texcoords,
              const std::vector<float> &in_positions,
              const std::vector<float> &in_normals,
              const std::vector<float> &in_texcoords, const vertex_index &i) {
-  const std::map<vertex_index, unsigned int>::iterator it = vertexCache.find(i);
+  unsigned int &cached = vertexCache.lookup(i);
 
-  if (it != vertexCache.end()) {
+  if (cached != vertex_cache::kEmpty) {
     // found cache
-    return it->second;
+    return cached;
   }
 
   assert(in_positions.size() > static_cast<unsigned int>(3 * i.v_idx + 2));
@@ -311,7 +542,7 @@ updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
   }
 
   unsigned int idx = static_cast<unsigned int>(positions.size() / 3 - 1);
-  vertexCache[i] = idx;
+  cached = idx;
 
   return idx;
 }
@@ -340,30 +571,31 @@ static void InitMaterial(material_t &material) {
 }
 
 static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
+    shape_t &shape, vertex_cache &vertexCache,
     const std::vector<float> &in_positions,
     const std::vector<float> &in_normals,
     const std::vector<float> &in_texcoords,
-    const std::vector<std::vector<vertex_index> > &faceGroup,
-    const int material_id, const std::string &name, bool clearCache) {
+    const face_group &faceGroup,
+    const int material_id, const std::string &name) {
   if (faceGroup.empty()) {
     return false;
   }
 
-  // Flatten vertices and indices
-  for (size_t i = 0; i < faceGroup.size(); i++) {
-    const std::vector<vertex_index> &face = faceGroup[i];
-
-    vertex_index i0 = face[0];
-    vertex_index i1(-1);
-    vertex_index i2 = face[1];
+  // Vertices are shared within a group only; every corner may be a new one
+  vertexCache.reset(faceGroup.indices.size());
+  shape.mesh.indices.reserve(3 * faceGroup.triangles);
+  shape.mesh.material_ids.reserve(faceGroup.triangles);
 
-    size_t npolys = face.size();
+  // Flatten vertices and indices
+  const vertex_index *face = faceGroup.indices.empty() ? NULL : &faceGroup.indices[0];
+  for (size_t i = 0; i < faceGroup.face_vertex_counts.size(); i++) {
+    size_t npolys = static_cast<size_t>(faceGroup.face_vertex_counts[i]);
 
     // Polygon -> triangle fan conversion
     for (size_t k = 2; k < npolys; k++) {
-      i1 = i2;
-      i2 = face[k];
+      vertex_index i0 = face[0];
+      vertex_index i1 = face[k - 1];
+      vertex_index i2 = face[k];
 
       unsigned int v0 = updateVertex(
           vertexCache, shape.mesh.positions, shape.mesh.normals,
@@ -381,13 +613,12 @@ static bool exportFaceGroupToShape(
 
       shape.mesh.material_ids.push_back(material_id);
     }
+
+    face += npolys;
   }
 
   shape.name = name;
 
-  if (clearCache)
-    vertexCache.clear();
-
   return true;
 }
 
@@ -642,74 +873,492 @@ bool MaterialFileReader::operator()(const std::string &matId,
   return true;
 }
 
-bool LoadObj(std::vector<shape_t> &shapes, // [output]
-             std::vector<material_t> &materials, // [output]
-             std::string &err,
-             const char *filename, const char *mtl_basepath) {
+// The state LoadObj carries from line to line: the vertex arrays, the faces
+// of the current group and what the next shape is made with. Statements
+// that end a group (usemtl, g, o) and mtllib go through statement(), which
+// the stream and the parallel loaders share.
+struct obj_reader {
+  obj_reader(std::vector<shape_t> &shapes, std::vector<material_t> &materials,
+             std::string &err, MaterialReader &readMatFn)
+      : shapes(shapes), materials(materials), err(err), readMatFn(readMatFn),
+        material(-1) {}
+
+  static bool isStatement(const char *token) {
+    return ((0 == strncmp(token, "usemtl", 6) ||
+             0 == strncmp(token, "mtllib", 6)) && isSpace(token[6])) ||
+           ((token[0] == 'g' || token[0] == 'o') && isSpace(token[1]));
+  }
 
-  shapes.clear();
+  // Exports the faces so far as a shape, if there are any
+  void flush() {
+    shape_t shape;
+    bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
+                                      faceGroup, material, name);
+    if (ret) {
+      shapes.push_back(std::move(shape));
+    }
+    faceGroup.clear();
+  }
 
-  std::stringstream errss;
+  // Applies a line for which isStatement() holds; false if a material
+  // library fails to load
+  bool statement(const char *token) {
+    // use mtl
+    if ((0 == strncmp(token, "usemtl", 6)) && isSpace((token[6]))) {
 
-  std::ifstream ifs(filename);
-  if (!ifs) {
-    errss << "Cannot open file [" << filename << "]" << std::endl;
-    err = errss.str();
-    return false;
-  }
+      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+      token += 7;
+#ifdef _MSC_VER
+      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+      sscanf(token, "%s", namebuf);
+#endif
 
-  std::string basePath;
-  if (mtl_basepath) {
-    basePath = mtl_basepath;
-  }
-  MaterialFileReader matFileReader(basePath);
+      // Create face group per material.
+      flush();
 
-  return LoadObj(shapes, materials, err, ifs, matFileReader);
-}
+      if (material_map.find(namebuf) != material_map.end()) {
+        material = material_map[namebuf];
+      } else {
+        // { error!! material not found }
+        material = -1;
+      }
 
-bool LoadObj(std::vector<shape_t> &shapes, // [output]
-             std::vector<material_t> &materials, // [output]
-             std::string& err,
-             std::istream &inStream, MaterialReader &readMatFn) {
-  std::stringstream errss;
+      return true;
+    }
+
+    // load mtl
+    if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) {
+      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+      token += 7;
+#ifdef _MSC_VER
+      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+      sscanf(token, "%s", namebuf);
+#endif
+
+      std::string err_mtl;
+      bool ok = readMatFn(namebuf, materials, material_map, err_mtl);
+      err += err_mtl;
+
+      if (!ok) {
+        faceGroup.clear(); // for safety
+        return false;
+      }
+
+      return true;
+    }
+
+    // group name
+    if (token[0] == 'g' && isSpace((token[1]))) {
+
+      // flush previous face group.
+      flush();
+
+      std::vector<std::string> names;
+      while (!isNewLine(token[0])) {
+        std::string str = parseString(token);
+        names.push_back(str);
+        token += strspn(token, " \t\r"); // skip tag
+      }
+
+      assert(names.size() > 0);
+
+      // names[0] must be 'g', so skip the 0th element.
+      if (names.size() > 1) {
+        name = names[1];
+      } else {
+        name = "";
+      }
+
+      return true;
+    }
+
+    // object name
+    if (token[0] == 'o' && isSpace((token[1]))) {
+
+      // flush previous face group.
+      flush();
+
+      // @todo { multiple object name? }
+      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+      token += 2;
+#ifdef _MSC_VER
+      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+      sscanf(token, "%s", namebuf);
+#endif
+      name = std::string(namebuf);
+    }
+
+    return true;
+  }
+
+  std::vector<shape_t> &shapes;
+  std::vector<material_t> &materials;
+  std::string &err;
+  MaterialReader &readMatFn;
 
   std::vector<float> v;
   std::vector<float> vn;
   std::vector<float> vt;
-  std::vector<std::vector<vertex_index> > faceGroup;
+  face_group faceGroup;
   std::string name;
 
   // material
   std::map<std::string, int> material_map;
-  std::map<vertex_index, unsigned int> vertexCache;
-  int material = -1;
+  vertex_cache vertexCache;
+  int material;
+};
 
-  shape_t shape;
+// Parses the corners of a face line (token after the 'f') into group. The
+// sizes are the vertex counts so far, for relative indices.
+static void parseFace(const char *token, int vsize, int vnsize, int vtsize,
+                      face_group &group) {
+  token += strspn(token, " \t");
 
-  int maxchars = 8192;             // Alloc enough size.
-  std::vector<char> buf(static_cast<size_t>(maxchars)); // Alloc enough size.
-  while (inStream.peek() != -1) {
-    inStream.getline(&buf[0], maxchars);
+  int corners = 0;
+  while (!isNewLine(token[0])) {
+    vertex_index vi = parseTriple(token, vsize, vnsize, vtsize);
+    group.indices.push_back(vi);
+    corners++;
+    size_t n = strspn(token, " \t\r");
+    token += n;
+  }
 
-    std::string linebuf(&buf[0]);
+  group.face_vertex_counts.push_back(corners);
+  if (corners > 2) {
+    group.triangles += static_cast<size_t>(corners - 2);
+  }
+}
 
-    // Trim newline '\r\n' or '\n'
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\n')
-        linebuf.erase(linebuf.size() - 1);
+// A read-only mapping of a whole file
+class mapped_file {
+public:
+  mapped_file() : data(NULL), size(0) {}
+  ~mapped_file() { close(); }
+
+  // Fails for files that cannot be opened or are empty
+  bool open(const char *filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
     }
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\r')
-        linebuf.erase(linebuf.size() - 1);
+    LARGE_INTEGER length;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+      mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
     }
+    if (mapping) {
+      data = static_cast<const char *>(
+          MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!data) {
+      return false;
+    }
+    size = static_cast<size_t>(length.QuadPart);
+#else
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE,
+               fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+    data = static_cast<const char *>(p);
+    size = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+  }
 
-    // Skip if empty line.
-    if (linebuf.empty()) {
+  void close() {
+    if (!data) {
+      return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char *>(data), size);
+#endif
+    data = NULL;
+    size = 0;
+  }
+
+  const char *data;
+  size_t size;
+
+private:
+  mapped_file(const mapped_file &);
+  mapped_file &operator=(const mapped_file &);
+};
+
+// A run of whole lines, each ending in '\n', that one thread parses
+struct obj_chunk {
+  const char *begin;
+  const char *end;
+
+  // The chunk's own vertices, and how many the chunks before it have
+  size_t v_count, vn_count, vt_count;
+  size_t v_first, vn_first, vt_first;
+
+  face_group faces;
+
+  // A statement line (copied, so the file can be unmapped before they are
+  // applied) and where it falls among the chunk's faces
+  struct statement {
+    face_group::mark at;
+    std::string line;
+  };
+  std::vector<statement> statements;
+
+  obj_chunk()
+      : begin(NULL), end(NULL), v_count(0), vn_count(0), vt_count(0),
+        v_first(0), vn_first(0), vt_first(0) {}
+};
+
+// Below this much per thread, starting threads costs more than it saves
+static const size_t kMinChunkBytes = 1 << 20;
+
+// Calls f on every chunk, chunk i > 0 on a thread of its own
+template <typename F>
+static void forEachChunk(std::vector<obj_chunk> &chunks, F f) {
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < chunks.size(); i++) {
+    workers.push_back(std::thread(f, &chunks[i]));
+  }
+  f(&chunks[0]);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+}
+
+// Counts the vertex lines, so that every chunk knows where its vertices go
+// and relative indices can be fixed while parsing
+static void countChunk(obj_chunk *chunk) {
+  for (const char *line = chunk->begin; line < chunk->end;) {
+    const char *next = static_cast<const char *>(
+        memchr(line, '\n', static_cast<size_t>(chunk->end - line))) + 1;
+    const char *token = line + strspn(line, " \t");
+    if (token[0] == 'v') {
+      if (isSpace(token[1])) {
+        chunk->v_count++;
+      } else if (token[1] == 'n' && isSpace(token[2])) {
+        chunk->vn_count++;
+      } else if (token[1] == 't' && isSpace(token[2])) {
+        chunk->vt_count++;
+      }
+    }
+    line = next;
+  }
+}
+
+static void parseChunk(obj_chunk *chunk, float *v, float *vn, float *vt) {
+  size_t nv = chunk->v_first;
+  size_t nvn = chunk->vn_first;
+  size_t nvt = chunk->vt_first;
+  for (const char *line = chunk->begin; line < chunk->end;) {
+    const char *next = static_cast<const char *>(
+        memchr(line, '\n', static_cast<size_t>(chunk->end - line))) + 1;
+    const char *token = line + strspn(line, " \t");
+    line = next;
+
+    if (token[0] == '#' || isNewLine(token[0])) {
+      continue;
+    }
+
+    // vertex
+    if (token[0] == 'v' && isSpace((token[1]))) {
+      token += 2;
+      parseFloat3(v[3 * nv + 0], v[3 * nv + 1], v[3 * nv + 2], token);
+      nv++;
       continue;
     }
 
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2]))) {
+      token += 3;
+      parseFloat3(vn[3 * nvn + 0], vn[3 * nvn + 1], vn[3 * nvn + 2], token);
+      nvn++;
+      continue;
+    }
+
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && isSpace((token[2]))) {
+      token += 3;
+      parseFloat2(vt[2 * nvt + 0], vt[2 * nvt + 1], token);
+      nvt++;
+      continue;
+    }
+
+    // face
+    if (token[0] == 'f' && isSpace((token[1]))) {
+      parseFace(token + 2, static_cast<int>(nv), static_cast<int>(nvn),
+                static_cast<int>(nvt), chunk->faces);
+      continue;
+    }
+
+    // The rest change state, so they are applied in order after parsing
+    if (obj_reader::isStatement(token)) {
+      const char *end = next - 1;
+      if (end > token && end[-1] == '\r') {
+        end--;
+      }
+      chunk->statements.push_back(obj_chunk::statement());
+      chunk->statements.back().at = chunk->faces.tell();
+      chunk->statements.back().line.assign(token, end);
+    }
+  }
+}
+
+bool LoadObj(std::vector<shape_t> &shapes, // [output]
+             std::vector<material_t> &materials, // [output]
+             std::string &err,
+             const char *filename, const char *mtl_basepath) {
+  return LoadObjParallel(shapes, materials, err, filename, mtl_basepath);
+}
+
+bool LoadObjParallel(std::vector<shape_t> &shapes, // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err,
+                     const char *filename, const char *mtl_basepath,
+                     unsigned int num_threads) {
+
+  shapes.clear();
+
+  std::stringstream errss;
+
+  std::string basePath;
+  if (mtl_basepath) {
+    basePath = mtl_basepath;
+  }
+  MaterialFileReader matFileReader(basePath);
+
+  mapped_file file;
+  if (!file.open(filename)) {
+    // Empty or unmappable files go through the stream loader
+    std::ifstream ifs(filename);
+    if (!ifs) {
+      errss << "Cannot open file [" << filename << "]" << std::endl;
+      err = errss.str();
+      return false;
+    }
+    return LoadObj(shapes, materials, err, ifs, matFileReader);
+  }
+
+  // A last line without a newline is parsed from a terminated copy, so no
+  // parser reads past the end of the mapping
+  const char *body_end = file.data + file.size;
+  std::string tail;
+  if (body_end[-1] != '\n') {
+    while (body_end > file.data && body_end[-1] != '\n') {
+      body_end--;
+    }
+    tail.assign(body_end, file.data + file.size);
+    tail += '\n';
+  }
+
+  size_t body = static_cast<size_t>(body_end - file.data);
+  size_t threads = num_threads;
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+    threads = std::min(threads, body / kMinChunkBytes);
+  }
+  threads = std::max(threads, static_cast<size_t>(1));
+
+  // Split at line boundaries into about equal parts
+  std::vector<obj_chunk> chunks(threads + (tail.empty() ? 0 : 1));
+  const char *begin = file.data;
+  for (size_t i = 0; i < threads; i++) {
+    const char *end = file.data + body * (i + 1) / threads;
+    if (end < begin) {
+      end = begin;
+    } else if (end > begin && end[-1] != '\n') {
+      end = static_cast<const char *>(
+          memchr(end, '\n', static_cast<size_t>(body_end - end))) + 1;
+    }
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    begin = end;
+  }
+  if (!tail.empty()) {
+    chunks.back().begin = tail.c_str();
+    chunks.back().end = tail.c_str() + tail.size();
+  }
+
+  forEachChunk(chunks, countChunk);
+
+  obj_reader reader(shapes, materials, err, matFileReader);
+  size_t nv = 0, nvn = 0, nvt = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    chunks[i].v_first = nv;
+    chunks[i].vn_first = nvn;
+    chunks[i].vt_first = nvt;
+    nv += chunks[i].v_count;
+    nvn += chunks[i].vn_count;
+    nvt += chunks[i].vt_count;
+  }
+  reader.v.resize(3 * nv);
+  reader.vn.resize(3 * nvn);
+  reader.vt.resize(2 * nvt);
+
+  float *v = reader.v.empty() ? NULL : &reader.v[0];
+  float *vn = reader.vn.empty() ? NULL : &reader.vn[0];
+  float *vt = reader.vt.empty() ? NULL : &reader.vt[0];
+  forEachChunk(chunks, [v, vn, vt](obj_chunk *chunk) {
+    parseChunk(chunk, v, vn, vt);
+  });
+  file.close();
+
+  // Replay each chunk's faces and statements in file order
+  for (size_t i = 0; i < chunks.size(); i++) {
+    obj_chunk &chunk = chunks[i];
+    face_group::mark from = face_group::mark();
+    for (size_t s = 0; s < chunk.statements.size(); s++) {
+      const obj_chunk::statement &st = chunk.statements[s];
+      reader.faceGroup.append(chunk.faces, from, st.at);
+      from = st.at;
+
+      if (!reader.statement(st.line.c_str())) {
+        return false;
+      }
+    }
+    if (from.faces == 0 && reader.faceGroup.empty()) {
+      std::swap(reader.faceGroup, chunk.faces);
+    } else {
+      reader.faceGroup.append(chunk.faces, from, chunk.faces.tell());
+      chunk.faces = face_group();
+    }
+  }
+
+  reader.flush();
+
+  err += errss.str();
+  return true;
+}
+
+bool LoadObj(std::vector<shape_t> &shapes, // [output]
+             std::vector<material_t> &materials, // [output]
+             std::string& err,
+             std::istream &inStream, MaterialReader &readMatFn) {
+  obj_reader reader(shapes, materials, err, readMatFn);
+
+  line_reader lines(inStream);
+  const char *line;
+  while ((line = lines.next()) != NULL) {
+
     // Skip leading space.
-    const char *token = linebuf.c_str();
+    const char *token = line;
     token += strspn(token, " \t");
 
     assert(token);
@@ -724,9 +1373,9 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       token += 2;
       float x, y, z;
       parseFloat3(x, y, z, token);
-      v.push_back(x);
-      v.push_back(y);
-      v.push_back(z);
+      reader.v.push_back(x);
+      reader.v.push_back(y);
+      reader.v.push_back(z);
       continue;
     }
 
@@ -735,9 +1384,9 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       token += 3;
       float x, y, z;
       parseFloat3(x, y, z, token);
-      vn.push_back(x);
-      vn.push_back(y);
-      vn.push_back(z);
+      reader.vn.push_back(x);
+      reader.vn.push_back(y);
+      reader.vn.push_back(z);
       continue;
     }
 
@@ -746,27 +1395,115 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       token += 3;
       float x, y;
       parseFloat2(x, y, token);
-      vt.push_back(x);
-      vt.push_back(y);
+      reader.vt.push_back(x);
+      reader.vt.push_back(y);
       continue;
     }
 
     // face
     if (token[0] == 'f' && isSpace((token[1]))) {
-      token += 2;
-      token += strspn(token, " \t");
+      parseFace(token + 2, static_cast<int>(reader.v.size() / 3),
+                static_cast<int>(reader.vn.size() / 3),
+                static_cast<int>(reader.vt.size() / 2), reader.faceGroup);
+      continue;
+    }
 
-      std::vector<vertex_index> face;
-      while (!isNewLine(token[0])) {
-        vertex_index vi =
-            parseTriple(token, static_cast<int>(v.size() / 3), static_cast<int>(vn.size() / 3), static_cast<int>(vt.size() / 2));
-        face.push_back(vi);
-        size_t n = strspn(token, " \t\r");
-        token += n;
+    // usemtl, mtllib, g, o
+    if (obj_reader::isStatement(token)) {
+      if (!reader.statement(token)) {
+        return false;
       }
+      continue;
+    }
+
+    // Ignore unknown command.
+  }
+
+  reader.flush();
+
+  return true;
+}
 
-      faceGroup.push_back(face);
+bool LoadObjWithCallback(std::istream &inStream, const callback_t &callback,
+                         void *user_data, MaterialReader *readMatFn,
+                         std::string &err) {
+  // Only counted for the kinds without a callback, to resolve relative indices
+  int nv = 0, nvn = 0, nvt = 0;
 
+  std::map<std::string, int> material_map;
+  std::vector<material_t> materials;
+
+  // Reused for every face
+  std::vector<index_t> face;
+
+  line_reader lines(inStream);
+  const char *line;
+  while ((line = lines.next()) != NULL) {
+
+    // Skip leading space.
+    const char *token = line;
+    token += strspn(token, " \t");
+
+    if (token[0] == '\0' || token[0] == '#')
+      continue; // empty or comment line
+
+    // vertex
+    if (token[0] == 'v' && isSpace((token[1]))) {
+      nv++;
+      if (callback.vertex_cb) {
+        token += 2;
+        float x, y, z;
+        parseFloat3(x, y, z, token);
+        callback.vertex_cb(user_data, x, y, z);
+      }
+      continue;
+    }
+
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2]))) {
+      nvn++;
+      if (callback.normal_cb) {
+        token += 3;
+        float x, y, z;
+        parseFloat3(x, y, z, token);
+        callback.normal_cb(user_data, x, y, z);
+      }
+      continue;
+    }
+
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && isSpace((token[2]))) {
+      nvt++;
+      if (callback.texcoord_cb) {
+        token += 3;
+        float x, y;
+        parseFloat2(x, y, token);
+        callback.texcoord_cb(user_data, x, y);
+      }
+      continue;
+    }
+
+    // face
+    if (token[0] == 'f' && isSpace((token[1]))) {
+      if (callback.index_cb) {
+        token += 2;
+        token += strspn(token, " \t");
+
+        face.clear();
+        while (!isNewLine(token[0])) {
+          vertex_index vi = parseTriple(token, nv, nvn, nvt);
+          index_t idx;
+          idx.vertex_index = vi.v_idx;
+          idx.normal_index = vi.vn_idx;
+          idx.texcoord_index = vi.vt_idx;
+          face.push_back(idx);
+          token += strspn(token, " \t\r");
+        }
+
+        if (!face.empty()) {
+          callback.index_cb(user_data, &face[0], static_cast<int>(face.size()));
+        }
+      }
       continue;
     }
 
@@ -781,119 +1518,84 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       sscanf(token, "%s", namebuf);
 #endif
 
-      // Create face group per material.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-          shapes.push_back(shape);
+      int material = -1;
+      std::map<std::string, int>::const_iterator it = material_map.find(namebuf);
+      if (it != material_map.end()) {
+        material = it->second;
       }
-      shape = shape_t();
-      faceGroup.clear();
 
-      if (material_map.find(namebuf) != material_map.end()) {
-        material = material_map[namebuf];
-      } else {
-        // { error!! material not found }
-        material = -1;
+      if (callback.usemtl_cb) {
+        callback.usemtl_cb(user_data, namebuf, material);
       }
-
       continue;
     }
 
     // load mtl
     if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) {
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 7;
+      if (readMatFn) {
+        char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        token += 7;
 #ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+        sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
 #else
-      sscanf(token, "%s", namebuf);
+        sscanf(token, "%s", namebuf);
 #endif
 
-      std::string err_mtl;
-      bool ok = readMatFn(namebuf, materials, material_map, err_mtl);
-      err += err_mtl;
-      
-      if (!ok) {
-        faceGroup.clear(); // for safety
-        return false;
-      }
+        std::string err_mtl;
+        bool ok = (*readMatFn)(namebuf, materials, material_map, err_mtl);
+        err += err_mtl;
 
+        if (!ok) {
+          return false;
+        }
+
+        if (callback.mtllib_cb && !materials.empty()) {
+          callback.mtllib_cb(user_data, &materials[0],
+                             static_cast<int>(materials.size()));
+        }
+      }
       continue;
     }
 
     // group name
     if (token[0] == 'g' && isSpace((token[1]))) {
+      if (callback.group_cb) {
+        // names[0] is 'g', so skip it.
+        std::vector<std::string> names;
+        while (!isNewLine(token[0])) {
+          std::string str = parseString(token);
+          names.push_back(str);
+          token += strspn(token, " \t\r"); // skip tag
+        }
 
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
-
-      shape = shape_t();
-
-      // material = -1;
-      faceGroup.clear();
-
-      std::vector<std::string> names;
-      while (!isNewLine(token[0])) {
-        std::string str = parseString(token);
-        names.push_back(str);
-        token += strspn(token, " \t\r"); // skip tag
-      }
-
-      assert(names.size() > 0);
-
-      // names[0] must be 'g', so skip the 0th element.
-      if (names.size() > 1) {
-        name = names[1];
-      } else {
-        name = "";
+        std::vector<const char *> name_ptrs;
+        for (size_t i = 1; i < names.size(); i++) {
+          name_ptrs.push_back(names[i].c_str());
+        }
+        callback.group_cb(user_data, name_ptrs.empty() ? NULL : &name_ptrs[0],
+                          static_cast<int>(name_ptrs.size()));
       }
-
       continue;
     }
 
     // object name
     if (token[0] == 'o' && isSpace((token[1]))) {
-
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
-
-      // material = -1;
-      faceGroup.clear();
-      shape = shape_t();
-
-      // @todo { multiple object name? }
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 2;
+      if (callback.object_cb) {
+        char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        token += 2;
 #ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+        sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
 #else
-      sscanf(token, "%s", namebuf);
+        sscanf(token, "%s", namebuf);
 #endif
-      name = std::string(namebuf);
-
+        callback.object_cb(user_data, namebuf);
+      }
       continue;
     }
 
     // Ignore unknown command.
   }
 
-  bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                    material, name, true);
-  if (ret) {
-    shapes.push_back(shape);
-  }
-  faceGroup.clear(); // for safety
-
-  err += errss.str();
   return true;
 }
 
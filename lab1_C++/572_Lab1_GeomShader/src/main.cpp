@@ -1,6 +1,7 @@
-// main.cpp — Load an OBJ with tinyobjloader, render it, and show normals via geometry shader
+// main.cpp — Load an OBJ with tinyobjloader, render it, and show per-vertex normals
+// Normals are drawn from a line buffer built once at load; --geometry-shader uses the old GS path
 // Build (Linux): g++ main.cpp -std=c++17 -lglfw -ldl -lGL -o obj_normals
-// Run: ./obj_normals path/to/model.obj
+// Run: ./obj_normals path/to/model.obj [--normal-stride N] [--normal-length L] [--geometry-shader]
 // Windows/MSVC: link opengl32.lib + glfw3 + glad (or use vcpkg: `vcpkg install glfw3 glad`)
 
 #include <iostream>
@@ -11,8 +12,12 @@
 #include <cmath>
 #include <vector>
 #include <string>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 #include <GLFW/glfw3.h>
 
 
@@ -109,6 +114,15 @@ void main(){
 }
 )";
 
+// Precomputed normal lines: endpoints are already in object space
+static const char* linesVS = R"(#version 330 core
+layout(location=0) in vec3 vertPos;
+uniform mat4 M, V, P;
+void main(){
+    gl_Position = P * V * M * vec4(vertPos,1.0);
+}
+)";
+
 static const char* normalsFS = R"(#version 330 core
 out vec4 FragColor;
 void main(){ FragColor = vec4(0.1, 0.95, 0.2, 1.0); }
@@ -133,71 +147,96 @@ static void makeScale(float s,float* m){ makeIdentity(m); m[0]=m[5]=m[10]=s; }
 // ---------- OBJ loading ----------
 struct Vertex { float px,py,pz, nx,ny,nz; };
 
-// Legacy tinyobjloader (no attrib/index_t) version
-static bool loadObjExpandTriangles(const std::string& path, std::vector<Vertex>& outVerts) {
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string err;
+// Welding key: vertices are equal when position and normal match bit for bit
+struct VertexHash {
+    size_t operator()(const Vertex& v) const {
+        uint32_t b[6]; std::memcpy(b, &v, sizeof(b));
+        uint64_t h = 1469598103934665603ull; // FNV-1a over the six floats
+        for (uint32_t x : b) h = (h ^ x) * 1099511628211ull;
+        return (size_t)h;
+    }
+};
+struct VertexEq {
+    bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+};
+
+// Positions and normals as tinyobj streams them, welded into outVerts/outIdx as
+// faces arrive. There is no texcoord callback, so those lines go unparsed.
+struct ObjReader {
+    std::vector<float> P, N;
+    std::vector<Vertex>& verts;
+    std::vector<uint32_t>& idx;
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEq> weld;
+
+    ObjReader(std::vector<Vertex>& v, std::vector<uint32_t>& i) : verts(v), idx(i) {}
+
+    void emit(const Vertex& v) {
+        auto it = weld.emplace(v, (uint32_t)verts.size());
+        if (it.second) verts.push_back(v);
+        idx.push_back(it.first->second);
+    }
 
-    // Old API signature: LoadObj(shapes, materials, err, filename)
-    bool ok = tinyobj::LoadObj(shapes, materials, err, path.c_str());
-    if (!err.empty()) std::cerr << "[TINYOBJ] " << err << "\n";
-    if (!ok) return false;
+    void triangle(const tinyobj::index_t* corner[3]) {
+        // Files list their vertices before the faces, so by the first face the
+        // count is known (near enough) to size the output
+        if (weld.empty()) {
+            weld.reserve(P.size() / 3);
+            verts.reserve(P.size() / 3);
+        }
+        float p[3][3], n[3][3];
+        bool hasN = true;
+        for (int k = 0; k < 3; k++) {
+            size_t vi = (size_t)corner[k]->vertex_index, ni = (size_t)corner[k]->normal_index;
+            if (corner[k]->vertex_index < 0 || 3*vi + 2 >= P.size()) return;
+            std::memcpy(p[k], &P[3*vi], sizeof(p[k]));
+            if (corner[k]->normal_index >= 0 && 3*ni + 2 < N.size()) std::memcpy(n[k], &N[3*ni], sizeof(n[k]));
+            else hasN = false;
+        }
 
-    outVerts.clear();
+        // If any normal is missing, compute a face normal
+        if (!hasN) {
+            float ux = p[1][0]-p[0][0], uy = p[1][1]-p[0][1], uz = p[1][2]-p[0][2];
+            float vx = p[2][0]-p[0][0], vy = p[2][1]-p[0][1], vz = p[2][2]-p[0][2];
+            float nx = uy*vz - uz*vy;
+            float ny = uz*vx - ux*vz;
+            float nz = ux*vy - uy*vx;
+            float len = std::sqrt(nx*nx + ny*ny + nz*nz); if (len < 1e-8f) len = 1.f;
+            nx/=len; ny/=len; nz/=len;
+            for (int k = 0; k < 3; k++) { n[k][0]=nx; n[k][1]=ny; n[k][2]=nz; }
+        }
 
-    for (const auto& sh : shapes) {
-        const auto& mesh = sh.mesh;
+        for (int k = 0; k < 3; k++) emit({ p[k][0], p[k][1], p[k][2], n[k][0], n[k][1], n[k][2] });
+    }
+};
 
-        // positions are packed as xyzxyz..., size = 3 * num_vertices
-        const auto& P = mesh.positions;  // std::vector<float>
-        const auto& N = mesh.normals;    // may be empty; size = 3 * num_vertices
-        const auto& I = mesh.indices;    // flat indices into P/N/TC with a single index stream
+// Triangles as an index buffer over welded (deduplicated) vertices
+static bool loadObjIndexed(const std::string& path, std::vector<Vertex>& outVerts, std::vector<uint32_t>& outIdx) {
+    std::ifstream in(path);
+    if (!in) { std::cerr << "[TINYOBJ] Cannot open file [" << path << "]\n"; return false; }
 
-        // Expect triangles (most OBJ meshes are triangulated in older loader output)
-        if (I.size() % 3 != 0) {
-            std::cerr << "[TINYOBJ] indices not divisible by 3; got " << I.size() << "\n";
+    outVerts.clear();
+    outIdx.clear();
+    ObjReader reader(outVerts, outIdx);
+
+    tinyobj::callback_t cb;
+    cb.vertex_cb = [](void* user, float x, float y, float z) {
+        auto& P = ((ObjReader*)user)->P; P.push_back(x); P.push_back(y); P.push_back(z);
+    };
+    cb.normal_cb = [](void* user, float x, float y, float z) {
+        auto& N = ((ObjReader*)user)->N; N.push_back(x); N.push_back(y); N.push_back(z);
+    };
+    // Polygons as triangle fans, like LoadObj
+    cb.index_cb = [](void* user, const tinyobj::index_t* face, int count) {
+        for (int k = 2; k < count; k++) {
+            const tinyobj::index_t* corner[3] = { &face[0], &face[k-1], &face[k] };
+            ((ObjReader*)user)->triangle(corner);
         }
+    };
 
-        for (size_t i = 0; i + 2 < I.size(); i += 3) {
-            unsigned int ia = I[i+0];
-            unsigned int ib = I[i+1];
-            unsigned int ic = I[i+2];
-
-            auto getP = [&](unsigned int idx, float out[3]) {
-                out[0] = P[3*idx + 0];
-                out[1] = P[3*idx + 1];
-                out[2] = P[3*idx + 2];
-            };
-            auto getN = [&](unsigned int idx, float out[3]) -> bool {
-                if (N.empty()) return false;
-                out[0] = N[3*idx + 0];
-                out[1] = N[3*idx + 1];
-                out[2] = N[3*idx + 2];
-                return true;
-            };
-
-            float pa[3], pb[3], pc[3]; getP(ia, pa); getP(ib, pb); getP(ic, pc);
-            float na[3], nb[3], nc[3];
-            bool hasNa = getN(ia, na), hasNb = getN(ib, nb), hasNc = getN(ic, nc);
-
-            // If any normal is missing, compute a face normal
-            if (!hasNa || !hasNb || !hasNc) {
-                float ux = pb[0]-pa[0], uy = pb[1]-pa[1], uz = pb[2]-pa[2];
-                float vx = pc[0]-pa[0], vy = pc[1]-pa[1], vz = pc[2]-pa[2];
-                float nx = uy*vz - uz*vy;
-                float ny = uz*vx - ux*vz;
-                float nz = ux*vy - uy*vx;
-                float len = std::sqrt(nx*nx + ny*ny + nz*nz); if (len < 1e-8f) len = 1.f;
-                nx/=len; ny/=len; nz/=len;
-                na[0]=nb[0]=nc[0]=nx; na[1]=nb[1]=nc[1]=ny; na[2]=nb[2]=nc[2]=nz;
-            }
-
-            outVerts.push_back({ pa[0], pa[1], pa[2], na[0], na[1], na[2] });
-            outVerts.push_back({ pb[0], pb[1], pb[2], nb[0], nb[1], nb[2] });
-            outVerts.push_back({ pc[0], pc[1], pc[2], nc[0], nc[1], nc[2] });
-        }
-    }
+    std::string err;
+    bool ok = tinyobj::LoadObjWithCallback(in, cb, &reader, nullptr, err);
+    if (!err.empty()) std::cerr << "[TINYOBJ] " << err << "\n";
+    if (!ok) return false;
 
     // Normalize to unit-ish size for viewing
     float minx=1e30f,miny=1e30f,minz=1e30f, maxx=-1e30f,maxy=-1e30f,maxz=-1e30f;
@@ -220,10 +259,34 @@ static bool loadObjExpandTriangles(const std::string& path, std::vector<Vertex>&
     return true;
 }
 
+// One segment (p, p + n*length) for every stride-th vertex; replaces the per-frame GS expansion
+static std::vector<float> buildNormalLines(const std::vector<Vertex>& verts, int stride, float length) {
+    stride = std::max(stride, 1);
+    std::vector<float> lines;
+    lines.reserve(6 * (verts.size() / stride + 1));
+    for (size_t i = 0; i < verts.size(); i += stride) {
+        const Vertex& v = verts[i];
+        float len = std::sqrt(v.nx*v.nx + v.ny*v.ny + v.nz*v.nz);
+        float k = len > 1e-8f ? length / len : 0.f;
+        lines.insert(lines.end(), { v.px, v.py, v.pz, v.px + v.nx*k, v.py + v.ny*k, v.pz + v.nz*k });
+    }
+    return lines;
+}
+
 int main(int argc, char** argv) {
-    const char* objPath = (argc >= 2) ? argv[1] : nullptr;
+    const char* objPath = nullptr;
+    int normalStride = 1;
+    float normalLength = 0.08f;
+    bool useGeometryShader = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--normal-stride" && i + 1 < argc) normalStride = std::atoi(argv[++i]);
+        else if (a == "--normal-length" && i + 1 < argc) normalLength = (float)std::atof(argv[++i]);
+        else if (a == "--geometry-shader") useGeometryShader = true;
+        else objPath = argv[i];
+    }
     if (!objPath) {
-        std::cerr << "Usage: " << argv[0] << " path/to/model.obj\n";
+        std::cerr << "Usage: " << argv[0] << " path/to/model.obj [--normal-stride N] [--normal-length L] [--geometry-shader]\n";
         return EXIT_FAILURE;
     }
 
@@ -245,9 +308,12 @@ int main(int argc, char** argv) {
     // Programs
     GLuint pMesh = linkProgram({ compile(GL_VERTEX_SHADER, meshVS),
                                  compile(GL_FRAGMENT_SHADER, meshFS) });
-    GLuint pNormals = linkProgram({ compile(GL_VERTEX_SHADER, normalsVS),
-                                    compile(GL_GEOMETRY_SHADER, normalsGS),
-                                    compile(GL_FRAGMENT_SHADER, normalsFS) });
+    GLuint pNormals = useGeometryShader
+        ? linkProgram({ compile(GL_VERTEX_SHADER, normalsVS),
+                        compile(GL_GEOMETRY_SHADER, normalsGS),
+                        compile(GL_FRAGMENT_SHADER, normalsFS) })
+        : linkProgram({ compile(GL_VERTEX_SHADER, linesVS),
+                        compile(GL_FRAGMENT_SHADER, normalsFS) });
 
     GLint uM_mesh = glGetUniformLocation(pMesh, "M");
     GLint uV_mesh = glGetUniformLocation(pMesh, "V");
@@ -260,21 +326,35 @@ int main(int argc, char** argv) {
 
     // Load OBJ
     std::vector<Vertex> verts;
-    if (!loadObjExpandTriangles(objPath, verts)) {
+    std::vector<uint32_t> indices;
+    if (!loadObjIndexed(objPath, verts, indices)) {
         std::cerr << "Failed to load OBJ: " << objPath << "\n";
         return EXIT_FAILURE;
     }
-    std::cout << "Loaded triangles: " << (verts.size()/3) << " (verts: " << verts.size() << ")\n";
+    std::cout << "Loaded triangles: " << (indices.size()/3) << " (verts: " << verts.size()
+              << " welded from " << indices.size() << ")\n";
 
-    // Create VAO/VBO
-    GLuint vao=0,vbo=0; glGenVertexArrays(1,&vao); glGenBuffers(1,&vbo);
+    // Create VAO/VBO/EBO
+    GLuint vao=0,vbo=0,ebo=0; glGenVertexArrays(1,&vao); glGenBuffers(1,&vbo); glGenBuffers(1,&ebo);
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, verts.size()*sizeof(Vertex), verts.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)0);
     glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)(3*sizeof(float)));
     glBindVertexArray(0);
 
+    // Normal lines, built once (the GS path ignores --normal-stride)
+    std::vector<float> lines = buildNormalLines(verts, normalStride, normalLength);
+    GLuint lineVao=0,lineVbo=0; glGenVertexArrays(1,&lineVao); glGenBuffers(1,&lineVbo);
+    glBindVertexArray(lineVao);
+    glBindBuffer(GL_ARRAY_BUFFER, lineVbo);
+    glBufferData(GL_ARRAY_BUFFER, lines.size()*sizeof(float), lines.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
+    glBindVertexArray(0);
+    if (!useGeometryShader) std::cout << "Normal lines: " << (lines.size()/6) << "\n";
+
     // Camera/projection
     int w=900,h=700;
     float P[16]; makePerspective(60.0f, float(w)/float(h), 0.05f, 100.0f, P);
@@ -302,18 +382,23 @@ int main(int argc, char** argv) {
         glUniformMatrix4fv(uV_mesh,1,GL_FALSE,V);
         glUniformMatrix4fv(uP_mesh,1,GL_FALSE,P);
         glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verts.size());
+        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
         glBindVertexArray(0);
 
-        // 2) Draw normals via geometry shader
+        // 2) Draw normals from the line buffer (or expand them in the geometry shader)
         glUseProgram(pNormals);
         glUniformMatrix4fv(uM_norm,1,GL_FALSE,M);
         glUniformMatrix4fv(uV_norm,1,GL_FALSE,V);
         glUniformMatrix4fv(uP_norm,1,GL_FALSE,P);
-        glUniform1f(uLen, 0.08f);
         glLineWidth(2.0f);
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verts.size());
+        if (useGeometryShader) {
+            glUniform1f(uLen, normalLength);
+            glBindVertexArray(vao);
+            glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
+        } else {
+            glBindVertexArray(lineVao);
+            glDrawArrays(GL_LINES, 0, (GLsizei)(lines.size()/3));
+        }
         glBindVertexArray(0);
         glLineWidth(1.0f);
 
@@ -322,6 +407,9 @@ int main(int argc, char** argv) {
 
     glDeleteVertexArrays(1,&vao);
     glDeleteBuffers(1,&vbo);
+    glDeleteBuffers(1,&ebo);
+    glDeleteVertexArrays(1,&lineVao);
+    glDeleteBuffers(1,&lineVbo);
     glDeleteProgram(pMesh);
     glDeleteProgram(pNormals);
     glfwTerminate();
@@ -0,0 +1,141 @@
+// Push/pop/multiply throughput of MatrixStack, and a render()-shaped frame
+// (three persistent stacks reset every frame, models pushed a few levels deep).
+//
+//   MatrixStackBench [iterations]
+//
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <glm/glm.hpp>
+
+#include "MatrixStack.h"
+
+using namespace std;
+using namespace glm;
+
+
+// Keeps the compiler from dropping the work
+static float sink = 0.f;
+
+template <typename F>
+static void run(const char *name, int iterations, F body)
+{
+	body(iterations / 100); // warm up
+
+	auto start = chrono::steady_clock::now();
+	body(iterations);
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+	printf("%-28s %8.2f ns/op\n", name, ns / iterations);
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = argc > 1 ? atoi(argv[1]) : 10000000;
+	if (iterations < 100)
+	{
+		fprintf(stderr, "usage: %s [iterations >= 100]\n", argv[0]);
+		return 1;
+	}
+
+	MatrixStack stack;
+	const mat4 m = translate(mat4(1.f), vec3(1.f, 2.f, 3.f));
+
+	run("pushMatrix + popMatrix", iterations, [&](int n) {
+		for (int i = 0; i < n; i++)
+		{
+			stack.pushMatrix();
+			sink += stack.topMatrix()[3][0];
+			stack.popMatrix();
+		}
+	});
+
+	// Deep enough to leave the first cache lines, well short of MaxMatrixSize
+	run("push 32 deep, pop 32 (per op)", iterations, [&](int n) {
+		for (int i = 0; i < n; i += 64)
+		{
+			for (int d = 0; d < 32; d++)
+			{
+				stack.pushMatrix();
+			}
+			sink += stack.topMatrix()[3][0];
+			for (int d = 0; d < 32; d++)
+			{
+				stack.popMatrix();
+			}
+		}
+	});
+
+	run("multMatrix", iterations, [&](int n) {
+		stack.pushMatrix();
+		for (int i = 0; i < n; i++)
+		{
+			stack.multMatrix(m);
+		}
+		sink += stack.topMatrix()[3][0];
+		stack.popMatrix();
+	});
+
+	run("translate", iterations, [&](int n) {
+		stack.pushMatrix();
+		for (int i = 0; i < n; i++)
+		{
+			stack.translate(vec3(0.f, 0.f, 1e-6f));
+		}
+		sink += stack.topMatrix()[3][0];
+		stack.popMatrix();
+	});
+
+	run("rotate", iterations, [&](int n) {
+		stack.pushMatrix();
+		for (int i = 0; i < n; i++)
+		{
+			stack.rotate(1e-6f, vec3(0, 1, 0));
+		}
+		sink += stack.topMatrix()[3][0];
+		stack.popMatrix();
+	});
+
+	run("scale", iterations, [&](int n) {
+		stack.pushMatrix();
+		for (int i = 0; i < n; i++)
+		{
+			stack.scale(1.f);
+		}
+		sink += stack.topMatrix()[3][0];
+		stack.popMatrix();
+	});
+
+	// What render() does: 3 stacks, 8 models, each 6 levels of push/transform/pop
+	MatrixStack projection, view, model;
+	int frames = iterations / 100;
+	auto start = chrono::steady_clock::now();
+	for (int f = 0; f < frames; f++)
+	{
+		projection.reset();
+		view.reset();
+		model.reset();
+		projection.perspective(45.f, 4.f / 3.f, 0.01f, 100.f);
+		view.translate(vec3(0, -1, -5));
+		for (int i = 0; i < 8; i++)
+		{
+			for (int d = 0; d < 6; d++)
+			{
+				model.pushMatrix();
+				model.translate(vec3(float(i), float(d), 0.f));
+				model.rotate(0.1f * d, vec3(0, 1, 0));
+				model.scale(vec3(0.9f));
+				sink += model.topMatrix()[3][0];
+			}
+			for (int d = 0; d < 6; d++)
+			{
+				model.popMatrix();
+			}
+		}
+	}
+	double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	printf("%-28s %8.2f us/frame\n", "render-shaped frame", us / frames);
+
+	return sink == 12345.f ? 1 : 0;
+}
@@ -2,13 +2,15 @@
 in vec3 vN;
 in vec3 vL;
 in vec3 vV;
+flat in int vMat;
 
-uniform vec3 MatAmb;
-uniform vec3 MatDif;
-uniform vec3 MatSpec;
-uniform float MatShine;
+// material table (MaterialRegistry), indexed per instance
+const int MAX_MATERIALS = 16;
+struct Material { vec3 amb; float shine; vec3 dif; vec3 spec; };
+layout(std140) uniform Materials { Material materials[MAX_MATERIALS]; };
 
-out vec4 FragColor;
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 FragNormal; // screen-space outline input
 
 float stepBand(float x, float bands) { return floor(x * bands) / bands; }
 
@@ -24,13 +26,15 @@ void main() {
     float dQ = stepBand(ndl, bands);
 
     // Thresholded specular highlight
-    float nsh = pow(max(dot(N, H), 0.0), MatShine);
+    Material mat = materials[vMat];
+    float nsh = pow(max(dot(N, H), 0.0), mat.shine);
     float sQ = step(0.5, nsh);         // binary highlight
 
     // Optional rim (ink near silhouette)
     float rim = pow(1.0 - max(dot(N, V), 0.0), 2.0);
     float rimQ = step(0.6, rim) * 0.25;
 
-    vec3 color = MatAmb + dQ * MatDif + sQ * MatSpec + rimQ * vec3(1.0);
+    vec3 color = mat.amb + dQ * mat.dif + sQ * mat.spec + rimQ * vec3(1.0);
     FragColor = vec4(color, 1.0);
+    FragNormal = vec4(N * 0.5 + 0.5, 1.0);
 }
\ No newline at end of file
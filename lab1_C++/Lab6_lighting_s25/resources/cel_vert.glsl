@@ -1,23 +1,30 @@
 #version 330 core
 layout(location=0) in vec3 vertPos;
 layout(location=1) in vec3 vertNor;
+layout(location=3) in mat4 instM;   // per-instance model (identity when not instanced)
+layout(location=7) in int instMat;  // per-instance material index
+layout(location=8) in vec3 vertPosScale; // position decode (set per draw by Shape)
+layout(location=9) in vec3 vertPosBias;
 
-uniform mat4 M, V, P;
-uniform vec3 lightPos; // world-space
+uniform mat4 M;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data (world-space light)
 
 out vec3 vN;  // normal in view space
 out vec3 vL;  // light dir in view space
 out vec3 vV;  // view dir in view space
+flat out int vMat;
 
 void main() {
-    vec4 wPos = M * vec4(vertPos, 1.0);
+    mat4 Model = M * instM;
+    vec4 wPos = Model * vec4(vertPosBias + vertPos * vertPosScale, 1.0);
     gl_Position = P * V * wPos;
 
-    mat3 N = mat3(transpose(inverse(M)));
+    mat3 N = mat3(transpose(inverse(Model)));
     vec3 nWS = normalize(N * vertNor);
     vN = normalize((V * vec4(nWS, 0.0)).xyz);
 
-    vec3 Lws = lightPos - wPos.xyz;
+    vec3 Lws = lightPos.xyz - wPos.xyz;
     vL = normalize((V * vec4(Lws, 0.0)).xyz);
     vV = normalize(-(V * wPos).xyz);
-}
\ No newline at end of file
+    vMat = instMat;
+}
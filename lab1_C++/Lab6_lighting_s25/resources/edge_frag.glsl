@@ -0,0 +1,32 @@
+#version 330 core
+in vec2 uv;
+uniform sampler2D colorTex;
+uniform sampler2D normalTex; // view-space normal in rgb, a = 1 on outlined geometry
+uniform sampler2D depthTex;
+uniform vec2 texelStep;      // outline thickness in uv units
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
+out vec4 FragColor;
+
+// positive view-space distance from the depth buffer (perspective P)
+float viewDepth(vec2 t){
+    float z = texture(depthTex, t).r * 2.0 - 1.0;
+    return P[3][2] / (z + P[2][2]);
+}
+
+void main(){
+    vec4 nc = texture(normalTex, uv);
+    float dc = viewDepth(uv);
+    vec2 offs[4] = vec2[](vec2(texelStep.x, 0.0), vec2(-texelStep.x, 0.0),
+                          vec2(0.0, texelStep.y), vec2(0.0, -texelStep.y));
+    float ink = 0.0;
+    for(int i=0;i<4;++i){
+        vec4 nn = texture(normalTex, uv + offs[i]);
+        if(nn.a == 0.0) continue;
+        float dn = viewDepth(uv + offs[i]);
+        // silhouette: ink the far side, like the inflated back-face hull did
+        if(nc.a == 0.0 || dn < dc * 0.97) { ink = 1.0; break; }
+        // crease between outlined surfaces at similar depth
+        if(dot(nc.xyz * 2.0 - 1.0, nn.xyz * 2.0 - 1.0) < 0.2) ink = 1.0;
+    }
+    FragColor = mix(texture(colorTex, uv), vec4(0.0, 0.0, 0.0, 1.0), ink);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+out vec2 uv;
+// fullscreen triangle from the vertex id, no vertex buffers
+void main(){
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = p;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+layout(location=0) in vec3 vertPos; // prebuilt normal line endpoints
+layout(location=3) in mat4 instM;   // per-instance model (identity when not instanced)
+uniform mat4 M;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
+void main(){
+    gl_Position = P * V * M * instM * vec4(vertPos, 1.0);
+}
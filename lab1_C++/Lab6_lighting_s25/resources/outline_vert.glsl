@@ -1,11 +1,15 @@
 #version 330 core
 layout(location=0) in vec3 vertPos;
 // layout(location=1) in vec3 vertNor;
+layout(location=3) in mat4 instM; // per-instance model (identity when not instanced)
+layout(location=8) in vec3 vertPosScale; // position decode (set per draw by Shape)
+layout(location=9) in vec3 vertPosBias;
 
-uniform mat4 M, V, P;
+uniform mat4 M;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
 // uniform float outlineScale; // small scale around origin, e.g. 0.01–0.03
 
 void main() {
-    vec3 pos = vertPos * (1.01);
-    gl_Position = P * V * (M * vec4(pos, 1.0));
-}
\ No newline at end of file
+    vec3 pos = (vertPosBias + vertPos * vertPosScale) * (1.01);
+    gl_Position = P * V * (M * instM * vec4(pos, 1.0));
+}
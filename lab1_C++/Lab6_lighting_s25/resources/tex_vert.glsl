@@ -2,9 +2,8 @@
 layout(location = 0) in vec3 vertPos;
 layout(location = 1) in vec3 vertNor;
 layout(location = 2) in vec2 vertTex;
-uniform mat4 P;
 uniform mat4 M;
-uniform mat4 V;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
 
 out vec2 vTexCoord;
 out vec3 fragNor;
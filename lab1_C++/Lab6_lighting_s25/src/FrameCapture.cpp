@@ -0,0 +1,202 @@
+#include "FrameCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "GLSL.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+using namespace std;
+
+
+typedef chrono::steady_clock Clock;
+
+FrameCapture::~FrameCapture()
+{
+	// Queued encodes still finish; readbacks that were never collected are lost
+	// (their buffers belong to the GL context, which may already be gone here)
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (thread &t : workers)
+	{
+		t.join();
+	}
+}
+
+void FrameCapture::capture(const string &fileName, int width, int height)
+{
+	Clock::time_point start = Clock::now();
+	if (workers.empty())
+	{
+		int threads = threadCount > 0 ? threadCount : (int)std::min(4u, std::max(1u, thread::hardware_concurrency()));
+		for (int i = 0; i < threads; i++)
+		{
+			workers.emplace_back(&FrameCapture::work, this);
+		}
+	}
+
+	// Pick up every readback the GPU has finished
+	for (Slot &slot : ring)
+	{
+		if (slot.fence)
+		{
+			collect(slot, false);
+		}
+	}
+
+	// The slot from RingSize frames ago must be free; it only waits when the GPU is that far behind
+	Slot &slot = ring[next];
+	if (slot.fence)
+	{
+		collect(slot, true);
+		waited++;
+	}
+	next = (next + 1) % RingSize;
+
+	size_t bytes = (size_t)width * height * 4;
+	if (slot.pbo == 0)
+	{
+		CHECKED_GL_CALL(glGenBuffers(1, &slot.pbo));
+	}
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+	if (slot.bytes != bytes)
+	{
+		CHECKED_GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ));
+		slot.bytes = bytes;
+	}
+	// With a pack buffer bound this only queues the copy
+	CHECKED_GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	CHECKED_GL_CALL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0));
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.fileName = fileName;
+	slot.width = width;
+	slot.height = height;
+
+	captured++;
+	captureMs += chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+bool FrameCapture::collect(Slot &slot, bool wait)
+{
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		if (!wait)
+		{
+			return false;
+		}
+		cerr << slot.fileName << ": readback timed out" << endl;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	Job job;
+	job.fileName = slot.fileName;
+	job.width = slot.width;
+	job.height = slot.height;
+	job.pixels.resize(slot.bytes);
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+	void *src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bytes, GL_MAP_READ_BIT);
+	if (src)
+	{
+		memcpy(job.pixels.data(), src, slot.bytes);
+		CHECKED_GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	}
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	if (!src)
+	{
+		cerr << slot.fileName << ": could not map the pixel buffer" << endl;
+		return false;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		if (jobs.size() >= MaxQueued)
+		{
+			throttled++;
+			idle.wait(lock, [this] { return jobs.size() < MaxQueued; });
+		}
+		jobs.push_back(std::move(job));
+		maxQueued = std::max(maxQueued, jobs.size());
+	}
+	wake.notify_one();
+	return true;
+}
+
+void FrameCapture::work()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			wake.wait(lock, [this] { return quit || !jobs.empty(); });
+			if (jobs.empty())
+			{
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			encoding++;
+		}
+
+		// Drop alpha (the window's alpha is whatever the shaders wrote) and flip to top-down rows
+		Clock::time_point start = Clock::now();
+		size_t row = (size_t)job.width * 3;
+		vector<unsigned char> rgb(row * job.height);
+		for (int y = 0; y < job.height; y++)
+		{
+			const unsigned char *src = &job.pixels[(size_t)(job.height - 1 - y) * job.width * 4];
+			unsigned char *dst = &rgb[y * row];
+			for (int x = 0; x < job.width; x++)
+			{
+				dst[3*x + 0] = src[4*x + 0];
+				dst[3*x + 1] = src[4*x + 1];
+				dst[3*x + 2] = src[4*x + 2];
+			}
+		}
+		if (!stbi_write_png(job.fileName.c_str(), job.width, job.height, 3, rgb.data(), (int)row))
+		{
+			cerr << "Could not write " << job.fileName << endl;
+		}
+		double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			encoding--;
+			encodeMs += ms;
+		}
+		idle.notify_all();
+	}
+}
+
+void FrameCapture::finish()
+{
+	// Oldest first, so the files complete in frame order
+	for (int i = 0; i < RingSize; i++)
+	{
+		Slot &slot = ring[(next + i) % RingSize];
+		if (slot.fence)
+		{
+			collect(slot, true);
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	idle.wait(lock, [this] { return jobs.empty() && encoding == 0; });
+	if (captured > 0)
+	{
+		cout << "captured " << captured << " frames: " << captureMs / captured << " ms per frame on the render thread ("
+			<< waited << " waits for the GPU, " << throttled << " for the encoders), " << encodeMs / captured
+			<< " ms per PNG on " << workers.size() << " encoder threads, at most " << maxQueued << " queued" << endl;
+		captured = waited = throttled = 0;
+		captureMs = encodeMs = 0.0;
+		maxQueued = 0;
+	}
+}
@@ -0,0 +1,46 @@
+#include "Frustum.h"
+#include <cmath>
+
+
+void Frustum::extract(const glm::mat4 &PV)
+{
+	// Rows of the combined matrix (glm is column-major)
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+	{
+		row[i] = glm::vec4(PV[0][i], PV[1][i], PV[2][i], PV[3][i]);
+	}
+
+	// left, right, bottom, top, near, far
+	for (int i = 0; i < 3; i++)
+	{
+		planes[2*i + 0] = row[3] + row[i];
+		planes[2*i + 1] = row[3] - row[i];
+	}
+}
+
+bool Frustum::intersects(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &M) const
+{
+	// World-space box around the transformed one: center plus |M| * half extent
+	glm::vec3 half = (max - min) * 0.5f;
+	glm::vec3 center = glm::vec3(M * glm::vec4((min + max) * 0.5f, 1.0f));
+	glm::vec3 extent(0);
+	for (int j = 0; j < 3; j++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			extent[i] += std::fabs(M[j][i]) * half[j];
+		}
+	}
+
+	for (int p = 0; p < 6; p++)
+	{
+		glm::vec3 n(planes[p]);
+		float r = std::fabs(n.x) * extent.x + std::fabs(n.y) * extent.y + std::fabs(n.z) * extent.z;
+		if (glm::dot(n, center) + planes[p].w < -r)
+		{
+			return false;
+		}
+	}
+	return true;
+}
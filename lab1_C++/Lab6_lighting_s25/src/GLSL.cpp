@@ -121,6 +121,53 @@ void checkVersion()
 	}
 }
 
+bool pollErrors = true;
+
+#ifdef GL_ERROR_CHECKS_CALLBACK
+static const char *debugTypeString(GLenum type)
+{
+	switch (type) {
+	case GL_DEBUG_TYPE_ERROR:
+		return "error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+		return "deprecated behavior";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+		return "undefined behavior";
+	case GL_DEBUG_TYPE_PORTABILITY:
+		return "portability";
+	case GL_DEBUG_TYPE_PERFORMANCE:
+		return "performance";
+	default:
+		return "message";
+	}
+}
+
+static void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
+{
+	// Set a breakpoint here and enable GL_DEBUG_OUTPUT_SYNCHRONOUS to see the failing call on the stack
+	printf("OpenGL %s (id %u): %s\n", debugTypeString(type), id, message);
+}
+#endif
+
+bool enableDebugOutput()
+{
+#ifdef GL_ERROR_CHECKS_CALLBACK
+	if (!GLAD_GL_KHR_debug)
+	{
+		printf("KHR_debug is not available, OpenGL errors are polled after every call instead\n");
+		return false;
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(debugCallback, nullptr);
+	// Errors and warnings only; notifications (buffer placement and the like) are noise
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+	pollErrors = false;
+	return true;
+#else
+	return false;
+#endif
+}
+
 GLint getAttribLocation(const GLuint program, const char varname[], bool verbose)
 {
 	GLint r = glGetAttribLocation(program, varname);
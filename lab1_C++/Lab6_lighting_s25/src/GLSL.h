@@ -20,6 +20,11 @@ namespace GLSL
 	void printProgramInfoLog(GLuint program);
 	void printShaderInfoLog(GLuint shader);
 	void checkVersion();
+	// Installs the KHR_debug message callback (GL_ERROR_CHECKS_CALLBACK builds only)
+	bool enableDebugOutput();
+	// GL_ERROR_CHECKS_CALLBACK builds: true until the callback is installed, and for good
+	// when the context has no KHR_debug, so that CHECKED_GL_CALL polls instead
+	extern bool pollErrors;
 	GLint getAttribLocation(const GLuint program, const char varname[], bool verbose = true);
 	GLint getUniformLocation(const GLuint program, const char varname[], bool verbose = true);
 	void enableVertexAttribArray(const GLint handle);
@@ -28,10 +33,20 @@ namespace GLSL
 }
 
 
-#ifndef DISABLE_OPENGL_ERROR_CHECKS
-#define CHECKED_GL_CALL(x) do { GLSL::printOpenGLErrors("{{BEFORE}} "#x, __FILE__, __LINE__); (x); GLSL::printOpenGLErrors(#x, __FILE__, __LINE__); } while (0)
-#else
+// How GL errors are found, picked with the GL_ERROR_CHECKS CMake option:
+//   GL_ERROR_CHECKS_POLL      glGetError before and after every CHECKED_GL_CALL; names the
+//                             exact call, but every check is a round trip into the driver
+//   GL_ERROR_CHECKS_CALLBACK  the driver reports errors to a KHR_debug callback as they
+//                             happen (see enableDebugOutput); CHECKED_GL_CALL costs one
+//                             test of pollErrors, and polls when KHR_debug is missing
+//   GL_ERROR_CHECKS_NONE      no checks at all
+// A build without any of these polls, as before.
+#if defined(DISABLE_OPENGL_ERROR_CHECKS) || defined(GL_ERROR_CHECKS_NONE)
 #define CHECKED_GL_CALL(x) (x)
+#elif defined(GL_ERROR_CHECKS_CALLBACK)
+#define CHECKED_GL_CALL(x) do { bool glslPoll = GLSL::pollErrors; if (glslPoll) GLSL::printOpenGLErrors("{{BEFORE}} "#x, __FILE__, __LINE__); (x); if (glslPoll) GLSL::printOpenGLErrors(#x, __FILE__, __LINE__); } while (0)
+#else
+#define CHECKED_GL_CALL(x) do { GLSL::printOpenGLErrors("{{BEFORE}} "#x, __FILE__, __LINE__); (x); GLSL::printOpenGLErrors(#x, __FILE__, __LINE__); } while (0)
 #endif
 
 #endif // LAB471_GLSL_H_INCLUDED
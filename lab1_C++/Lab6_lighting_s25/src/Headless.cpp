@@ -0,0 +1,92 @@
+#include "Headless.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+#include "GLSL.h"
+
+using namespace std;
+
+
+static double nowMs()
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Headless::init()
+{
+	CHECKED_GL_CALL(glGenRenderbuffers(1, &colorID));
+	CHECKED_GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, colorID));
+	CHECKED_GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+	CHECKED_GL_CALL(glGenRenderbuffers(1, &depthID));
+	CHECKED_GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, depthID));
+	CHECKED_GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+	CHECKED_GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	CHECKED_GL_CALL(glGenFramebuffers(1, &fboID));
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fboID));
+	CHECKED_GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorID));
+	CHECKED_GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthID));
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	if (!complete)
+	{
+		cerr << "Headless framebuffer is incomplete" << endl;
+		return false;
+	}
+
+	frameMs.reserve(frames);
+	cout << "headless: " << frames << " frames at " << width << "x" << height << endl;
+	return true;
+}
+
+void Headless::beginFrame()
+{
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fboID));
+	frameStart = nowMs();
+}
+
+void Headless::endFrame()
+{
+	// Wait for the GPU so the time covers the whole frame, not just its submission
+	glFinish();
+	frameMs.push_back(nowMs() - frameStart);
+
+	bool last = frame == frames - 1;
+	if (!dumpPrefix.empty() && ((dumpEvery > 0 && frame % dumpEvery == 0) || (dumpEvery == 0 && last)))
+	{
+		char number[16];
+		snprintf(number, sizeof(number), "%04d", frame);
+		capture.capture(dumpPrefix + number + ".png", width, height);
+	}
+	frame++;
+}
+
+void Headless::report()
+{
+	capture.finish();
+	if (frameMs.empty())
+	{
+		return;
+	}
+	cout << fixed << setprecision(3) << "headless: first frame " << frameMs[0] << " ms";
+
+	vector<double> sorted(frameMs.begin() + 1, frameMs.end());
+	if (!sorted.empty())
+	{
+		sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double ms : sorted)
+		{
+			sum += ms;
+		}
+		double mean = sum / sorted.size();
+		size_t n = sorted.size();
+		cout << ", then " << n << " frames: mean " << mean << " ms (" << setprecision(1) << 1000.0 / mean << " fps)"
+			<< setprecision(3) << ", min " << sorted[0] << ", median " << sorted[n / 2]
+			<< ", p95 " << sorted[std::min(n - 1, n * 95 / 100)] << ", max " << sorted[n - 1] << " ms";
+	}
+	cout << defaultfloat << endl;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef LAB471_HEADLESS_H_INCLUDED
+#define LAB471_HEADLESS_H_INCLUDED
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+#include "FrameCapture.h"
+
+
+// Benchmark mode: renders a fixed number of frames into an offscreen
+// framebuffer (the window stays hidden) and animates them with time(), a
+// fixed 60 Hz clock, so every run draws the same images. Each frame is
+// finished with glFinish and timed, the statistics are printed at the end,
+// and frames can be saved as PNG (read back and encoded asynchronously).
+class Headless
+{
+
+public:
+
+	// frames > 0 turns headless mode on
+	void setFrames(int n) { frames = n; }
+	bool isEnabled() const { return frames > 0; }
+	void setSize(int w, int h) { width = w; height = h; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	// Saves <prefix>NNNN.png for every frame that is a multiple of every;
+	// every = 0 saves only the last frame
+	void setDump(const std::string &prefix, int every) { dumpPrefix = prefix; dumpEvery = every; }
+
+	// Needs the GL context; creates the framebuffer
+	bool init();
+
+	bool done() const { return frame >= frames; }
+	double time() const { return frame / 60.0; }
+
+	// Bind the framebuffer / finish, time and save the frame
+	void beginFrame();
+	void endFrame();
+
+	// Frame time statistics (the first frame, which compiles and uploads lazily, is listed apart);
+	// also waits for the saved frames
+	void report();
+
+private:
+
+	int frames = 0;
+	int width = 640;
+	int height = 480;
+	std::string dumpPrefix;
+	int dumpEvery = 0;
+	FrameCapture capture;
+
+	GLuint fboID = 0;
+	GLuint colorID = 0;
+	GLuint depthID = 0;
+
+	int frame = 0;
+	double frameStart = 0.0;
+	std::vector<double> frameMs;
+
+};
+
+#endif // LAB471_HEADLESS_H_INCLUDED
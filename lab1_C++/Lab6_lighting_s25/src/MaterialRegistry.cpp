@@ -0,0 +1,25 @@
+#include "MaterialRegistry.h"
+#include <cassert>
+
+
+int MaterialRegistry::add(const glm::vec3 &amb, const glm::vec3 &dif, const glm::vec3 &spec, float shine)
+{
+	assert(size() < MaxMaterials);
+
+	Material m;
+	m.amb = amb;
+	m.shine = shine;
+	m.dif = dif;
+	m.pad0 = 0;
+	m.spec = spec;
+	m.pad1 = 0;
+	materials.push_back(m);
+	return size() - 1;
+}
+
+void MaterialRegistry::init(GLuint binding)
+{
+	// Sized for the full table so the shader block never reads past the end
+	ubo.init(MaxMaterials * sizeof(Material), binding);
+	ubo.update(materials.data(), materials.size() * sizeof(Material));
+}
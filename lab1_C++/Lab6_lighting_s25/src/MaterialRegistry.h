@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef LAB471_MATERIALREGISTRY_H_INCLUDED
+#define LAB471_MATERIALREGISTRY_H_INCLUDED
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "UniformBuffer.h"
+
+
+// All materials of a scene in one uniform buffer, uploaded once. Draws pick a
+// material by index (Shape::Instance::material or the generic attribute set
+// for non-instanced draws), so nothing is uploaded per object.
+class MaterialRegistry
+{
+
+public:
+
+	// Must match MAX_MATERIALS in the shaders' Materials block
+	static const int MaxMaterials = 16;
+
+	// Returns the index the shaders use to reach the material
+	int add(const glm::vec3 &amb, const glm::vec3 &dif, const glm::vec3 &spec, float shine);
+	void init(GLuint binding);
+	int size() const { return (int)materials.size(); }
+
+private:
+
+	// std140 layout of the shaders' Material struct
+	struct Material
+	{
+		glm::vec3 amb;
+		float shine;
+		glm::vec3 dif;
+		float pad0;
+		glm::vec3 spec;
+		float pad1;
+	};
+
+	std::vector<Material> materials;
+	UniformBuffer ubo;
+
+};
+
+#endif // LAB471_MATERIALREGISTRY_H_INCLUDED
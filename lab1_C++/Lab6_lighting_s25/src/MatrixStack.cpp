@@ -1,74 +1,87 @@
 
 #include "MatrixStack.h"
 #include <glm/gtc/matrix_transform.hpp>
-
-static const int MaxMatrixSize = 100;
+#include <cassert>
+#include <cstdio>
 
 
 MatrixStack::MatrixStack()
 {
-	stack.push(glm::mat4(1.0));
+	reset();
+}
+
+void MatrixStack::reset()
+{
+	depth = 0;
+	stack[0] = glm::mat4(1.0);
 }
 
 void MatrixStack::pushMatrix()
 {
-	const glm::mat4 &top = stack.top();
-	stack.push(top);
-	assert(stack.size() < MaxMatrixSize);
+	// The storage is fixed, so a push past it is refused instead of written out of bounds
+	if (depth + 1 >= MaxMatrixSize)
+	{
+		fprintf(stderr, "MatrixStack: pushMatrix() past %d matrices ignored\n", MaxMatrixSize);
+		return;
+	}
+	stack[depth + 1] = stack[depth];
+	depth++;
 }
 
 void MatrixStack::popMatrix()
 {
-	assert(!stack.empty());
-	stack.pop();
-
 	// There should always be one matrix left.
-	assert(!stack.empty());
+	if (depth == 0)
+	{
+		fprintf(stderr, "MatrixStack: popMatrix() of the last matrix ignored\n");
+		return;
+	}
+	depth--;
 }
 
 void MatrixStack::loadIdentity()
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	top = glm::mat4(1.f);
 }
 
 void MatrixStack::perspective(float fovy, float aspect, float zNear, float zFar)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	top *= glm::perspective(fovy, aspect, zNear, zFar);
 }
 
 void MatrixStack::translate(const glm::vec3 &offset)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	glm::mat4 t = glm::translate(glm::mat4(1.f), offset);
 	top *= t;
 }
 
 void MatrixStack::scale(const glm::vec3 &scaleV)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	glm::mat4 s = glm::scale(glm::mat4(1.f), scaleV);
 	top *= s;
 }
 
 void MatrixStack::scale(float size)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	glm::mat4 s = glm::scale(glm::mat4(1.f), glm::vec3(size));
 	top *= s;
 }
 
 void MatrixStack::rotate(float angle, const glm::vec3 &axis)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	glm::mat4 r = glm::rotate(glm::mat4(1.0), angle, axis);
 	top *= r;
 }
 
 void MatrixStack::multMatrix(const glm::mat4 &matrix)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	top *= matrix;
 }
 
@@ -78,25 +91,25 @@ void MatrixStack::ortho(float left, float right, float bottom, float top, float
 	assert(bottom != top);
 	assert(zFar != zNear);
 
-	glm::mat4 &ctm = stack.top();
+	glm::mat4 &ctm = stack[depth];
 	ctm *= glm::ortho(left, right, bottom, top, zNear, zFar);
 }
 
 void MatrixStack::frustum(float left, float right, float bottom, float top, float zNear, float zFar)
 {
-	glm::mat4 &ctm = stack.top();
+	glm::mat4 &ctm = stack[depth];
 	ctm *= glm::frustum(left, right, bottom, top, zNear, zFar);
 }
 
 void MatrixStack::lookAt(const glm::vec3 &eye, const glm::vec3 &target, const glm::vec3 &up)
 {
-	glm::mat4 &top = stack.top();
+	glm::mat4 &top = stack[depth];
 	top *= glm::lookAt(eye, target, up);
 }
 
 const glm::mat4 &MatrixStack::topMatrix() const
 {
-	return stack.top();
+	return stack[depth];
 }
 
 void MatrixStack::print(const glm::mat4 &mat, const char *name)
@@ -124,5 +137,5 @@ void MatrixStack::print(const glm::mat4 &mat, const char *name)
 
 void MatrixStack::print(const char *name) const
 {
-	print(stack.top(), name);
+	print(stack[depth], name);
 }
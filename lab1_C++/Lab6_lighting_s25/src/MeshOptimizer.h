@@ -0,0 +1,40 @@
+#pragma once
+#ifndef LAB471_MESHOPTIMIZER_H_INCLUDED
+#define LAB471_MESHOPTIMIZER_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+
+// Load-time reordering of indexed triangle meshes for the GPU:
+// post-transform cache (Tipsify), overdraw-aware cluster order and vertex fetch order
+namespace MeshOptimizer
+{
+
+	// Post-transform cache size assumed by the reordering and the statistics
+	const int CacheSize = 16;
+
+	// Vertex cache statistics from a FIFO cache simulation
+	struct CacheStats
+	{
+		float acmr; // transformed vertices per triangle (1.0 is ideal for big meshes, 3.0 is worst)
+		float atvr; // transformed vertices per vertex (1.0 is ideal)
+	};
+	CacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize = CacheSize);
+
+	// Tipsify triangle order (Sander et al. 2007). Writes the start of every
+	// cluster (a run ending where the fan walk hit a dead end) to clusters.
+	void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &clusters, int cacheSize = CacheSize);
+
+	// Orders the clusters so outward-facing ones on the outside of the mesh go
+	// first, which lets them occlude the rest (positions are xyz packed)
+	void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<float> &positions, const std::vector<unsigned int> &clusters);
+
+	// Renumbers vertices in first-use order; remap[old] gives the new index.
+	// Returns the remap so every attribute array can be reordered with remapAttribute.
+	std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int> &indices, size_t vertexCount);
+	void remapAttribute(std::vector<float> &attribute, int components, const std::vector<unsigned int> &remap);
+
+}
+
+#endif // LAB471_MESHOPTIMIZER_H_INCLUDED
@@ -0,0 +1,116 @@
+#include "OutlinePass.h"
+#include <iostream>
+
+#include "GLSL.h"
+#include "Program.h"
+
+using namespace std;
+
+
+void OutlinePass::init(const string &resourceDirectory, GLuint frameBinding)
+{
+	edgeProg = make_shared<Program>();
+	edgeProg->setVerbose(true);
+	edgeProg->setShaderNames(resourceDirectory + "/edge_vert.glsl", resourceDirectory + "/edge_frag.glsl", "");
+	edgeProg->init();
+	edgeProg->bindUniformBlock("Frame", frameBinding);
+	colorSampler = edgeProg->uniform<int>("colorTex");
+	normalSampler = edgeProg->uniform<int>("normalTex");
+	depthSampler = edgeProg->uniform<int>("depthTex");
+	texelStep = edgeProg->uniform<glm::vec2>("texelStep");
+
+	// The fullscreen triangle is generated from gl_VertexID, but core
+	// profiles still need a VAO bound to draw
+	CHECKED_GL_CALL(glGenVertexArrays(1, &vaoID));
+	CHECKED_GL_CALL(glGenFramebuffers(1, &fboID));
+	CHECKED_GL_CALL(glGenTextures(1, &colorTexID));
+	CHECKED_GL_CALL(glGenTextures(1, &normalTexID));
+	CHECKED_GL_CALL(glGenTextures(1, &depthTexID));
+}
+
+static void allocTarget(GLuint tid, GLint internalFormat, GLenum format, GLenum type, int width, int height)
+{
+	CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, tid));
+	CHECKED_GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr));
+	CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+}
+
+void OutlinePass::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	allocTarget(colorTexID, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+	allocTarget(normalTexID, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+	allocTarget(depthTexID, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+	CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fboID));
+	CHECKED_GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexID, 0));
+	CHECKED_GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexID, 0));
+	CHECKED_GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexID, 0));
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cerr << "Outline framebuffer is incomplete" << endl;
+	}
+}
+
+void OutlinePass::begin(int width, int height)
+{
+	if (width != this->width || height != this->height)
+	{
+		resize(width, height);
+	}
+
+	// The window, or an offscreen target when running headless
+	GLint target = 0;
+	CHECKED_GL_CALL(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target));
+	targetID = (GLuint)target;
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fboID));
+
+	// Normal alpha marks outlined geometry; the background stays at zero
+	const GLfloat noNormal[] = {0.5f, 0.5f, 1.0f, 0.0f};
+	writeNormals(true);
+	CHECKED_GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+	CHECKED_GL_CALL(glClearBufferfv(GL_COLOR, 1, noNormal));
+}
+
+void OutlinePass::writeNormals(bool enable) const
+{
+	const GLenum buffers[] = {GL_COLOR_ATTACHMENT0, enable ? GLenum(GL_COLOR_ATTACHMENT1) : GLenum(GL_NONE)};
+	CHECKED_GL_CALL(glDrawBuffers(2, buffers));
+}
+
+void OutlinePass::end() const
+{
+	CHECKED_GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, targetID));
+
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	CHECKED_GL_CALL(glDisable(GL_DEPTH_TEST));
+
+	edgeProg->bind();
+	CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0));
+	CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, colorTexID));
+	CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE1));
+	CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, normalTexID));
+	CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE2));
+	CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, depthTexID));
+	colorSampler.set(0);
+	normalSampler.set(1);
+	depthSampler.set(2);
+	texelStep.set(glm::vec2(thickness / width, thickness / height));
+
+	CHECKED_GL_CALL(glBindVertexArray(vaoID));
+	CHECKED_GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 3));
+	CHECKED_GL_CALL(glBindVertexArray(0));
+	edgeProg->unbind();
+
+	CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0));
+	if (depthTest)
+	{
+		CHECKED_GL_CALL(glEnable(GL_DEPTH_TEST));
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef LAB471_OUTLINEPASS_H_INCLUDED
+#define LAB471_OUTLINEPASS_H_INCLUDED
+
+#include <string>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Uniform.h"
+
+class Program;
+
+
+// Screen-space outline: the scene is drawn once into an FBO holding color,
+// view-space normal and depth, then a fullscreen pass inks silhouettes and
+// creases where depth/normals are discontinuous. Replaces the inflated
+// back-face pass, so outlined geometry is submitted only once.
+class OutlinePass
+{
+
+public:
+
+	void init(const std::string &resourceDirectory, GLuint frameBinding);
+
+	// Redirects drawing into the FBO (reallocated when the size changes)
+	void begin(int width, int height);
+	// Outlined geometry also writes its normal; overlays only write color
+	void writeNormals(bool enable) const;
+	// Composites the inked image into the framebuffer that was bound at begin()
+	void end() const;
+
+	// Outline width in pixels
+	float thickness = 1.5f;
+
+private:
+
+	void resize(int width, int height);
+
+	std::shared_ptr<Program> edgeProg;
+	Uniform<int> colorSampler, normalSampler, depthSampler;
+	Uniform<glm::vec2> texelStep;
+
+	GLuint fboID = 0;
+	GLuint targetID = 0;
+	GLuint colorTexID = 0;
+	GLuint normalTexID = 0;
+	GLuint depthTexID = 0;
+	GLuint vaoID = 0;
+	int width = 0;
+	int height = 0;
+
+};
+
+#endif // LAB471_OUTLINEPASS_H_INCLUDED
@@ -0,0 +1,210 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "GLSL.h"
+
+using namespace std;
+
+
+// Overlay bar colors, in pass order
+static const float Palette[][3] = {
+	{0.9f, 0.2f, 0.2f}, {0.2f, 0.8f, 0.2f}, {0.2f, 0.4f, 0.9f},
+	{0.9f, 0.8f, 0.1f}, {0.8f, 0.2f, 0.8f}, {0.1f, 0.8f, 0.8f}};
+static const char *PaletteNames[] = {"red", "green", "blue", "yellow", "magenta", "cyan"};
+static const int PaletteSize = 6;
+
+bool Profiler::openCsv(const string &fileName)
+{
+	csv.open(fileName, ios::trunc);
+	if (!csv)
+	{
+		cerr << "Could not open " << fileName << " for the profile" << endl;
+		return false;
+	}
+	csv << "frame,pass,cpu_ms,gpu_ms" << endl;
+	return true;
+}
+
+void Profiler::beginFrame()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	// Frame time is start to start, so it includes the swap and any wait on the GPU
+	Clock::time_point now = Clock::now();
+	if (frame > 0)
+	{
+		frameSum += chrono::duration<double, milli>(now - frameStart).count();
+		frameCount++;
+	}
+	frameStart = now;
+
+	// Pick up whatever the GPU has finished; unfinished queries are left for later
+	for (Pass &pass : passes)
+	{
+		for (Sample &sample : pass.ring)
+		{
+			if (sample.pending)
+			{
+				collect(pass, sample);
+			}
+		}
+	}
+}
+
+void Profiler::endFrame()
+{
+	if (!enabled)
+	{
+		return;
+	}
+	frame++;
+	if (frameCount >= reportInterval)
+	{
+		report();
+	}
+}
+
+void Profiler::begin(const char *name)
+{
+	if (!enabled)
+	{
+		return;
+	}
+	if (active >= 0)
+	{
+		cerr << "Profiler: " << name << " begins inside " << passes[active].name << endl;
+		end();
+	}
+
+	size_t index = 0;
+	while (index < passes.size() && passes[index].name != name)
+	{
+		index++;
+	}
+	if (index == passes.size())
+	{
+		passes.push_back(Pass());
+		passes.back().name = name;
+	}
+
+	// The slot was issued Latency frames ago; if the GPU still has not finished it, drop it
+	Sample &sample = passes[index].ring[frame % Latency];
+	if (sample.pending && !collect(passes[index], sample))
+	{
+		sample.pending = false;
+		dropped++;
+	}
+	if (sample.query == 0)
+	{
+		CHECKED_GL_CALL(glGenQueries(1, &sample.query));
+	}
+
+	active = (int)index;
+	sample.frame = frame;
+	CHECKED_GL_CALL(glBeginQuery(GL_TIME_ELAPSED, sample.query));
+	passStart = Clock::now();
+}
+
+void Profiler::end()
+{
+	if (!enabled || active < 0)
+	{
+		return;
+	}
+	Pass &pass = passes[active];
+	Sample &sample = pass.ring[frame % Latency];
+	CHECKED_GL_CALL(glEndQuery(GL_TIME_ELAPSED));
+	sample.cpuMs = chrono::duration<double, milli>(Clock::now() - passStart).count();
+	sample.pending = true;
+	pass.cpuSum += sample.cpuMs;
+	pass.cpuCount++;
+	active = -1;
+}
+
+bool Profiler::collect(Pass &pass, Sample &sample)
+{
+	GLint available = 0;
+	CHECKED_GL_CALL(glGetQueryObjectiv(sample.query, GL_QUERY_RESULT_AVAILABLE, &available));
+	if (!available)
+	{
+		return false;
+	}
+	GLuint64 ns = 0;
+	CHECKED_GL_CALL(glGetQueryObjectui64v(sample.query, GL_QUERY_RESULT, &ns));
+	double gpuMs = ns / 1e6;
+	pass.gpuSum += gpuMs;
+	pass.gpuCount++;
+	sample.pending = false;
+	if (csv)
+	{
+		csv << sample.frame << "," << pass.name << "," << sample.cpuMs << "," << gpuMs << "\n";
+	}
+	return true;
+}
+
+void Profiler::report()
+{
+	cout << fixed << setprecision(3) << "profile frames " << frame - frameCount << "-" << frame - 1
+		<< ": frame " << frameSum / frameCount << " ms";
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		Pass &pass = passes[i];
+		pass.cpuAvg = pass.cpuCount ? pass.cpuSum / pass.cpuCount : 0.0;
+		pass.gpuAvg = pass.gpuCount ? pass.gpuSum / pass.gpuCount : 0.0;
+		cout << " | " << pass.name;
+		if (overlay)
+		{
+			cout << " (" << PaletteNames[i % PaletteSize] << ")";
+		}
+		cout << " cpu " << pass.cpuAvg << " gpu " << pass.gpuAvg;
+		pass.cpuSum = pass.gpuSum = 0.0;
+		pass.cpuCount = pass.gpuCount = 0;
+	}
+	if (dropped)
+	{
+		cout << " (" << dropped << " queries dropped)";
+	}
+	cout << defaultfloat << endl;
+	frameSum = 0.0;
+	frameCount = 0;
+	dropped = 0;
+}
+
+void Profiler::drawOverlay(int width, int height) const
+{
+	if (!enabled || !overlay)
+	{
+		return;
+	}
+
+	// Bars are scissored clears, so the overlay needs no shader or geometry
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glEnable(GL_SCISSOR_TEST);
+	float scale = (width - 16) / (1000.0f / 60.0f);
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		const float *color = Palette[i % PaletteSize];
+		int y = height - 16 - (int)i * 12;
+		int gpuWidth = std::min(width - 16, (int)(passes[i].gpuAvg * scale + 0.5f));
+		int cpuWidth = std::min(width - 16, (int)(passes[i].cpuAvg * scale + 0.5f));
+		glClearColor(color[0], color[1], color[2], 1.0f);
+		if (gpuWidth > 0)
+		{
+			glScissor(8, y, gpuWidth, 6);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+		if (cpuWidth > 0)
+		{
+			glScissor(8, y - 3, cpuWidth, 2);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+	}
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
@@ -5,6 +5,7 @@
 #include <fstream>
 
 #include "GLSL.h"
+#include "ProgramCache.h"
 
 
 std::string readFileAsString(const std::string &fileName)
@@ -39,26 +40,34 @@ bool Program::init()
 {
 	GLint rc;
 
+	// Read shader sources
+	std::string vShaderString = readFileAsString(vShaderName);
+	std::string fShaderString = readFileAsString(fShaderName);
+	std::string gShaderString = gShaderName != "" ? readFileAsString(gShaderName) : "";
+
+	// Reuse the linked binary from an earlier run when sources and driver are unchanged
+	std::string cachePath = ProgramCache::path(vShaderName, fShaderName, gShaderName);
+	uint64_t cacheKey = ProgramCache::hash({vShaderString, fShaderString, gShaderString});
+	pid = ProgramCache::load(cachePath, cacheKey);
+	if (pid != 0)
+	{
+		return true;
+	}
+
 	// Create shader handles
 	GLuint VS = glCreateShader(GL_VERTEX_SHADER);
 	GLuint FS = glCreateShader(GL_FRAGMENT_SHADER);
 	GLuint GS = 0;
 
-	// If a geometric shader is passed, create the handles and read the sources
+	// If a geometric shader is passed, create the handle
 	bool geoshader = false;
 	if(gShaderName != ""){
 		geoshader = true;
 		GS = glCreateShader(GL_GEOMETRY_SHADER);
-		std::string gShaderString = readFileAsString(gShaderName);
 		const char *gshader = gShaderString.c_str();
 		CHECKED_GL_CALL(glShaderSource(GS, 1, &gshader, NULL));
 	}
-	
-	
 
-	// Read shader sources
-	std::string vShaderString = readFileAsString(vShaderName);
-	std::string fShaderString = readFileAsString(fShaderName);
 	const char *vshader = vShaderString.c_str();
 	const char *fshader = fShaderString.c_str();
 	CHECKED_GL_CALL(glShaderSource(VS, 1, &vshader, NULL));
@@ -112,6 +121,12 @@ bool Program::init()
 		CHECKED_GL_CALL(glAttachShader(pid, GS));
 	}
 	CHECKED_GL_CALL(glAttachShader(pid, FS));
+	// Pin the vertex inputs to the locations Shape records in its VAO
+	// (explicit layout qualifiers in the shader take precedence)
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 0, "vertPos"));
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 1, "vertNor"));
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 2, "vertTex"));
+	ProgramCache::prepare(pid);
 	CHECKED_GL_CALL(glLinkProgram(pid));
 	CHECKED_GL_CALL(glGetProgramiv(pid, GL_LINK_STATUS, &rc));
 	if (!rc)
@@ -123,6 +138,7 @@ bool Program::init()
 		}
 		return false;
 	}
+	ProgramCache::store(cachePath, cacheKey, pid);
 	return true;
 }
 
@@ -141,9 +157,25 @@ void Program::addAttribute(const std::string &name)
 	attributes[name] = GLSL::getAttribLocation(pid, name.c_str(), isVerbose());
 }
 
-void Program::addUniform(const std::string &name)
+GLint Program::addUniform(const std::string &name)
 {
-	uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
+	GLint location = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
+	uniforms[name] = location;
+	return location;
+}
+
+void Program::bindUniformBlock(const std::string &name, GLuint binding) const
+{
+	GLuint index = glGetUniformBlockIndex(pid, name.c_str());
+	if (index == GL_INVALID_INDEX)
+	{
+		if (isVerbose())
+		{
+			std::cout << name << " is not a uniform block" << std::endl;
+		}
+		return;
+	}
+	CHECKED_GL_CALL(glUniformBlockBinding(pid, index, binding));
 }
 
 GLint Program::getAttribute(const std::string &name) const
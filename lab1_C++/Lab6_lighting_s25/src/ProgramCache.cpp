@@ -0,0 +1,225 @@
+#include "ProgramCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <GLFW/glfw3.h>
+
+#include "GLSL.h"
+
+// GL 4.1 / ARB_get_program_binary is not in the GL 3.3 loader, so the entry
+// points are fetched from GLFW at first use
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+using namespace std;
+
+
+namespace ProgramCache
+{
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+static GetProgramBinaryProc getProgramBinary = nullptr;
+static ProgramBinaryProc programBinary = nullptr;
+static ProgramParameteriProc programParameteri = nullptr;
+
+// Bump whenever Program::init changes something baked in at link time (attribute bindings)
+static const uint32_t CacheVersion = 1;
+
+struct FileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t driverLength;
+	uint32_t format;
+	uint32_t binaryLength;
+};
+
+static const string &driver()
+{
+	static string name;
+	if (name.empty())
+	{
+		const char *strings[] = {
+			(const char *)glGetString(GL_VENDOR), (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION)};
+		for (const char *s : strings)
+		{
+			name += s ? s : "?";
+			name += '\n';
+		}
+	}
+	return name;
+}
+
+static string baseName(const string &fileName)
+{
+	size_t slash = fileName.find_last_of("/\\");
+	return slash == string::npos ? fileName : fileName.substr(slash + 1);
+}
+
+// Unique to this process and thread, so two runs of the app storing the same
+// program never write into the same temp file
+static string tempPath(const string &path)
+{
+#ifdef _WIN32
+	unsigned long pid = (unsigned long)_getpid();
+#else
+	unsigned long pid = (unsigned long)getpid();
+#endif
+	return path + ".tmp" + to_string(pid) + "_" + to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+bool supported()
+{
+	static int state = -1;
+	if (state < 0)
+	{
+		getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+		programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+		programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+		GLint formats = 0;
+		if (getProgramBinary && programBinary && programParameteri)
+		{
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			glGetError(); // GL_INVALID_ENUM when the query is unknown
+		}
+		state = formats > 0 ? 1 : 0;
+	}
+	return state == 1;
+}
+
+string path(const string &vShaderName, const string &fShaderName, const string &gShaderName)
+{
+	// One file per shader set, next to the vertex shader: cel_vert.glsl+cel_frag.glsl.bin
+	string result = vShaderName + "+" + baseName(fShaderName);
+	if (!gShaderName.empty())
+	{
+		result += "+" + baseName(gShaderName);
+	}
+	return result + ".bin";
+}
+
+uint64_t hash(const vector<string> &sources)
+{
+	uint64_t h = 1469598103934665603ull; // FNV-1a
+	for (const string &source : sources)
+	{
+		for (unsigned char c : source)
+		{
+			h = (h ^ c) * 1099511628211ull;
+		}
+		h = (h ^ 0xff) * 1099511628211ull; // keeps "ab","c" apart from "a","bc"
+	}
+	return h;
+}
+
+GLuint load(const string &path, uint64_t key)
+{
+	if (!supported())
+	{
+		return 0;
+	}
+	ifstream in(path, ios::binary);
+	FileHeader header;
+	if (!in.read((char *)&header, sizeof(header)) || memcmp(header.magic, "PRG1", 4) != 0 || header.version != CacheVersion || header.key != key)
+	{
+		return 0;
+	}
+	// The lengths come from the file: the driver string must be as long as this
+	// driver's and the binary must fill the rest, as store() writes them,
+	// before anything is allocated from them
+	in.seekg(0, ios::end);
+	streamoff rest = in.tellg() - (streamoff)sizeof(header);
+	in.seekg(sizeof(header));
+	if (header.driverLength != driver().size() || rest != (streamoff)header.driverLength + (streamoff)header.binaryLength)
+	{
+		return 0;
+	}
+	// A driver update invalidates binaries; glProgramBinary would fail anyway, but this avoids the attempt
+	string storedDriver(header.driverLength, '\0');
+	if (!in.read(&storedDriver[0], storedDriver.size()) || storedDriver != driver())
+	{
+		return 0;
+	}
+	vector<char> binary(header.binaryLength);
+	if (!in.read(binary.data(), binary.size()))
+	{
+		return 0;
+	}
+
+	GLuint pid = glCreateProgram();
+	programBinary(pid, header.format, binary.data(), (GLsizei)binary.size());
+	GLint rc = GL_FALSE;
+	glGetProgramiv(pid, GL_LINK_STATUS, &rc);
+	if (!rc)
+	{
+		glGetError(); // a rejected format raises GL_INVALID_ENUM
+		glDeleteProgram(pid);
+		return 0;
+	}
+	return pid;
+}
+
+void prepare(GLuint pid)
+{
+	if (supported())
+	{
+		CHECKED_GL_CALL(programParameteri(pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	}
+}
+
+void store(const string &path, uint64_t key, GLuint pid)
+{
+	if (!supported())
+	{
+		return;
+	}
+	GLint length = 0;
+	CHECKED_GL_CALL(glGetProgramiv(pid, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0)
+	{
+		return;
+	}
+	vector<char> binary(length);
+	GLenum format = 0;
+	CHECKED_GL_CALL(getProgramBinary(pid, length, &length, &format, binary.data()));
+
+	const string &name = driver();
+	FileHeader header = {{'P', 'R', 'G', '1'}, CacheVersion, key, (uint32_t)name.size(), (uint32_t)format, (uint32_t)length};
+
+	// Write to a temp file and rename it into place so another run never reads half a binary
+	string tmpPath = tempPath(path);
+	bool written = false;
+	{
+		ofstream out(tmpPath, ios::binary | ios::trunc);
+		written = out && out.write((const char *)&header, sizeof(header)) && out.write(name.data(), name.size()) && out.write(binary.data(), length);
+	}
+	if (written)
+	{
+#ifdef _WIN32
+		std::remove(path.c_str()); // rename does not replace on Windows
+#endif
+		written = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+	}
+	if (!written)
+	{
+		std::remove(tmpPath.c_str());
+	}
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef LAB471_RENDERQUEUE_H_INCLUDED
+#define LAB471_RENDERQUEUE_H_INCLUDED
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Uniform.h"
+
+class Program;
+class Texture;
+class Profiler;
+
+
+// Collects a frame's draws and issues them sorted by state rather than in
+// submission order. Each draw gets a 64-bit key - pass, program, material,
+// texture, then view depth (front to back) - and execute() walks the sorted
+// list binding a program, texture or material only when it differs from the
+// one already in place. Passes run in the order they were added; each is
+// timed as one profiler section and may set fixed-function state in hooks.
+class RenderQueue
+{
+
+public:
+
+	// Issues the draw call once the queue has set the state. Kept by the
+	// caller (built once, e.g. in init) so submitting a draw never allocates.
+	typedef std::function<void()> Call;
+
+	struct Draw
+	{
+		int pass = 0;
+		// Not owned; must stay alive until execute()
+		Program *program = nullptr;
+		// Optional; bound to its unit, which is handed to the sampler uniform
+		Texture *texture = nullptr;
+		Uniform<int> sampler;
+		// Material index for the draw (-1: the draw brings its own, e.g. per instance)
+		int material = -1;
+		// Uploaded right before the call
+		Uniform<glm::mat4> modelUniform;
+		glm::mat4 model = glm::mat4(1.0f);
+		// View-space distance for ordering; negative takes the model's origin
+		float depth = -1.0f;
+		const Call *call = nullptr;
+	};
+
+	// Counts for the last executed frame
+	struct Stats
+	{
+		int draws = 0;
+		int passes = 0;
+		int programBinds = 0;
+		int textureBinds = 0;
+		int materialChanges = 0;
+		// Binds and material changes filtered out because the state was already set
+		int redundant = 0;
+
+		bool operator==(const Stats &o) const;
+	};
+
+	// Passes execute in the order they are added; returns the index for Draw::pass
+	int addPass(const std::string &name, std::function<void()> begin = nullptr, std::function<void()> end = nullptr);
+
+	// Starts a frame; the view matrix places draws for depth ordering
+	void begin(const glm::mat4 &view);
+	void submit(const Draw &draw);
+
+	// Sorts and draws everything submitted since begin(), timing each pass with the profiler if given
+	void execute(Profiler *profiler = nullptr);
+
+	const Stats &getStats() const { return stats; }
+
+	// Prints the state change counts whenever they differ from the last frame's
+	void reportChanges();
+
+private:
+
+	struct Pass
+	{
+		std::string name;
+		std::function<void()> begin;
+		std::function<void()> end;
+	};
+
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t index;
+
+		// Submission order breaks ties so equal keys draw as submitted
+		bool operator<(const Entry &o) const { return key != o.key ? key < o.key : index < o.index; }
+	};
+
+	uint64_t makeKey(const Draw &draw);
+	// Small stable number for a program/texture (1-255; 0 is none), assigned on first use
+	static uint64_t slot(std::vector<const void *> &ids, const void *id);
+
+	std::vector<Pass> passes;
+	std::vector<Draw> draws;
+	std::vector<Entry> order;
+	std::vector<const void *> programIds;
+	std::vector<const void *> textureIds;
+	glm::mat4 view = glm::mat4(1.0f);
+
+	Stats stats;
+	Stats reported;
+	bool hasReported = false;
+
+};
+
+#endif // LAB471_RENDERQUEUE_H_INCLUDED
@@ -2,13 +2,88 @@
 #include "Shape.h"
 #include <iostream>
 #include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <glm/glm.hpp>
 
 #include "GLSL.h"
-#include "Program.h"
+#include "Frustum.h"
+#include "MeshOptimizer.h"
 
 using namespace std;
 
 
+// Maps x in [bias, bias + scale] to the full unsigned 16-bit range
+static uint16_t quantizeUnorm16(float x, float bias, float scale)
+{
+	if (scale <= 0.0f)
+	{
+		return 0;
+	}
+	float t = std::max(0.0f, std::min(1.0f, (x - bias) / scale));
+	return (uint16_t)std::lround(t * 65535.0f);
+}
+
+// Unit normal as signed normalized 10:10:10 (GL_INT_2_10_10_10_REV, w = 0)
+static uint32_t packNormal(const float *n)
+{
+	float len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+	float inv = len > 0.0f ? 1.0f / len : 0.0f;
+	uint32_t packed = 0;
+	for (int k = 0; k < 3; k++)
+	{
+		int q = (int)std::lround(std::max(-1.0f, std::min(1.0f, n[k] * inv)) * 511.0f);
+		packed |= ((uint32_t)q & 0x3ff) << (10 * k);
+	}
+	return packed;
+}
+
+// IEEE half precision, rounded to nearest; tiny values go through the half denormals
+static uint16_t floatToHalf(float f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+	uint32_t sign = (x >> 16) & 0x8000;
+	int exponent = (int)((x >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = x & 0x7fffff;
+
+	if (((x >> 23) & 0xff) == 0xff)
+	{
+		return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	if (exponent >= 31)
+	{
+		return (uint16_t)(sign | 0x7c00);
+	}
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return (uint16_t)sign;
+		}
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+		{
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+	{
+		half++; // a carry into the exponent is still the right rounding
+	}
+	return (uint16_t)half;
+}
+
+
 // copy the data from the shape to this object
 void Shape::createShape(tinyobj::shape_t & shape)
 {
@@ -18,6 +93,33 @@ void Shape::createShape(tinyobj::shape_t & shape)
 	eleBuf = shape.mesh.indices;
 }
 
+void Shape::createShape(tinyobj::shape_t && shape)
+{
+	posBuf = std::move(shape.mesh.positions);
+	norBuf = std::move(shape.mesh.normals);
+	texBuf = std::move(shape.mesh.texcoords);
+	eleBuf = std::move(shape.mesh.indices);
+}
+
+void Shape::optimize()
+{
+	size_t vertexCount = posBuf.size() / 3;
+	MeshOptimizer::CacheStats before = MeshOptimizer::analyzeVertexCache(eleBuf, vertexCount);
+
+	vector<unsigned int> clusters;
+	MeshOptimizer::optimizeVertexCache(eleBuf, vertexCount, clusters);
+	MeshOptimizer::optimizeOverdraw(eleBuf, posBuf, clusters);
+
+	vector<unsigned int> remap = MeshOptimizer::optimizeVertexFetch(eleBuf, vertexCount);
+	MeshOptimizer::remapAttribute(posBuf, 3, remap);
+	MeshOptimizer::remapAttribute(norBuf, 3, remap);
+	MeshOptimizer::remapAttribute(texBuf, 2, remap);
+
+	MeshOptimizer::CacheStats after = MeshOptimizer::analyzeVertexCache(eleBuf, vertexCount);
+	cout << "mesh optimized: " << eleBuf.size() / 3 << " triangles, " << clusters.size() << " clusters, ACMR "
+		<< before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << endl;
+}
+
 void Shape::measure()
 {
 	float minX, minY, minZ;
@@ -47,102 +149,338 @@ void Shape::measure()
 	max.z = maxZ;
 }
 
-void Shape::init()
+void Shape::init(bool compressed)
 {
+	size_t vertexCount = posBuf.size() / 3;
+	bool hasNor = !norBuf.empty();
+	bool hasTex = !texBuf.empty();
+
+	// One interleaved buffer: position, then the normal and texcoords when present
+	size_t posSize = compressed ? 4*sizeof(uint16_t) : 3*sizeof(float);
+	size_t norSize = hasNor ? (compressed ? sizeof(uint32_t) : 3*sizeof(float)) : 0;
+	size_t texSize = hasTex ? (compressed ? 2*sizeof(uint16_t) : 2*sizeof(float)) : 0;
+	size_t stride = posSize + norSize + texSize;
+	size_t norOffset = posSize;
+	size_t texOffset = posSize + norSize;
+
+	// Compressed positions are unorm16 within the bounds; the shaders undo it with posScale/posBias
+	if (compressed)
+	{
+		measure();
+		posBias = min;
+		posScale = max - min;
+	}
+	else
+	{
+		posBias = glm::vec3(0);
+		posScale = glm::vec3(1);
+	}
+
+	vector<unsigned char> vertices(vertexCount * stride);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		unsigned char *dst = &vertices[v * stride];
+		if (compressed)
+		{
+			uint16_t pos[4] = {0, 0, 0, 0};
+			for (int k = 0; k < 3; k++)
+			{
+				pos[k] = quantizeUnorm16(posBuf[3*v + k], posBias[k], posScale[k]);
+			}
+			memcpy(dst, pos, posSize);
+			if (hasNor)
+			{
+				uint32_t nor = packNormal(&norBuf[3*v]);
+				memcpy(dst + norOffset, &nor, norSize);
+			}
+			if (hasTex)
+			{
+				uint16_t tex[2] = {floatToHalf(texBuf[2*v + 0]), floatToHalf(texBuf[2*v + 1])};
+				memcpy(dst + texOffset, tex, texSize);
+			}
+		}
+		else
+		{
+			memcpy(dst, &posBuf[3*v], posSize);
+			if (hasNor)
+			{
+				memcpy(dst + norOffset, &norBuf[3*v], norSize);
+			}
+			if (hasTex)
+			{
+				memcpy(dst + texOffset, &texBuf[2*v], texSize);
+			}
+		}
+	}
+
 	// Initialize the vertex array object
 	CHECKED_GL_CALL(glGenVertexArrays(1, &vaoID));
 	CHECKED_GL_CALL(glBindVertexArray(vaoID));
 
-	// Send the position array to the GPU
-	CHECKED_GL_CALL(glGenBuffers(1, &posBufID));
-	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, posBufID));
-	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, posBuf.size()*sizeof(float), &posBuf[0], GL_STATIC_DRAW));
-
-	// Send the normal array to the GPU
-	if (norBuf.empty())
+	// Send the vertex array to the GPU
+	CHECKED_GL_CALL(glGenBuffers(1, &vertBufID));
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vertBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(PosAttrib));
+	if (compressed)
 	{
-		norBufID = 0;
+		CHECKED_GL_CALL(glVertexAttribPointer(PosAttrib, 3, GL_UNSIGNED_SHORT, GL_TRUE, (GLsizei)stride, (const void *)0));
 	}
 	else
 	{
-		CHECKED_GL_CALL(glGenBuffers(1, &norBufID));
-		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, norBufID));
-		CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, norBuf.size()*sizeof(float), &norBuf[0], GL_STATIC_DRAW));
+		CHECKED_GL_CALL(glVertexAttribPointer(PosAttrib, 3, GL_FLOAT, GL_FALSE, (GLsizei)stride, (const void *)0));
 	}
 
-	// Send the texture array to the GPU
-	if (texBuf.empty())
+	if (hasNor)
 	{
-		texBufID = 0;
+		CHECKED_GL_CALL(glEnableVertexAttribArray(NorAttrib));
+		if (compressed)
+		{
+			CHECKED_GL_CALL(glVertexAttribPointer(NorAttrib, 4, GL_INT_2_10_10_10_REV, GL_TRUE, (GLsizei)stride, (const void *)norOffset));
+		}
+		else
+		{
+			CHECKED_GL_CALL(glVertexAttribPointer(NorAttrib, 3, GL_FLOAT, GL_FALSE, (GLsizei)stride, (const void *)norOffset));
+		}
 	}
-	else
+
+	if (hasTex)
 	{
-		CHECKED_GL_CALL(glGenBuffers(1, &texBufID));
-		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, texBufID));
-		CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, texBuf.size()*sizeof(float), &texBuf[0], GL_STATIC_DRAW));
+		CHECKED_GL_CALL(glEnableVertexAttribArray(TexAttrib));
+		CHECKED_GL_CALL(glVertexAttribPointer(TexAttrib, 2, compressed ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, (GLsizei)stride, (const void *)texOffset));
 	}
 
-	// Send the element array to the GPU
+	// Send the element array to the GPU, as 16-bit indices whenever they fit
 	CHECKED_GL_CALL(glGenBuffers(1, &eleBufID));
 	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eleBufID));
-	CHECKED_GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, eleBuf.size()*sizeof(unsigned int), &eleBuf[0], GL_STATIC_DRAW));
+	size_t indexBytes;
+	if (vertexCount <= 65536)
+	{
+		vector<uint16_t> shortBuf(eleBuf.begin(), eleBuf.end());
+		eleType = GL_UNSIGNED_SHORT;
+		indexBytes = shortBuf.size()*sizeof(uint16_t);
+		CHECKED_GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, shortBuf.data(), GL_STATIC_DRAW));
+	}
+	else
+	{
+		eleType = GL_UNSIGNED_INT;
+		indexBytes = eleBuf.size()*sizeof(unsigned int);
+		CHECKED_GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, eleBuf.data(), GL_STATIC_DRAW));
+	}
 
-	// Unbind the arrays
+	// Unbind the VAO first so it keeps the element buffer binding
+	CHECKED_GL_CALL(glBindVertexArray(0));
 	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+
+	size_t floatBytes = (posBuf.size() + norBuf.size() + texBuf.size())*sizeof(float) + eleBuf.size()*sizeof(unsigned int);
+	cout << "shape uploaded: " << vertexCount << " vertices x " << stride << " bytes" << (compressed ? " (compressed)" : "")
+		<< ", " << (vertices.size() + indexBytes) / 1024 << " KB (float/32-bit: " << floatBytes / 1024 << " KB)" << endl;
+
+	// Non-instanced draws leave the instance arrays disabled, so the shaders
+	// read the generic attribute values instead: identity transform, material 0
+	for (int c = 0; c < 4; c++)
+	{
+		CHECKED_GL_CALL(glVertexAttrib4f(InstanceAttrib + c, c == 0, c == 1, c == 2, c == 3));
+	}
+	CHECKED_GL_CALL(glVertexAttribI4i(InstanceAttrib + 4, 0, 0, 0, 0));
 }
 
-void Shape::draw(const shared_ptr<Program> prog) const
+void Shape::appendPooled(vector<unsigned char> &vertices, vector<unsigned int> &indices, glm::vec3 &scale, glm::vec3 &bias) const
 {
-	int h_pos, h_nor, h_tex;
-	h_pos = h_nor = h_tex = -1;
+	// Same encoding as init(true), but every attribute is present so all pooled shapes share one stride
+	const size_t stride = 16;
+	size_t vertexCount = posBuf.size() / 3;
+	bias = min;
+	scale = max - min;
 
-	CHECKED_GL_CALL(glBindVertexArray(vaoID));
+	size_t first = vertices.size();
+	vertices.resize(first + vertexCount * stride);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		unsigned char *dst = &vertices[first + v * stride];
+		uint16_t pos[4] = {0, 0, 0, 0};
+		for (int k = 0; k < 3; k++)
+		{
+			pos[k] = quantizeUnorm16(posBuf[3*v + k], bias[k], scale[k]);
+		}
+		uint32_t nor = norBuf.empty() ? 0 : packNormal(&norBuf[3*v]);
+		uint16_t tex[2] = {0, 0};
+		if (!texBuf.empty())
+		{
+			tex[0] = floatToHalf(texBuf[2*v + 0]);
+			tex[1] = floatToHalf(texBuf[2*v + 1]);
+		}
+		memcpy(dst, pos, sizeof(pos));
+		memcpy(dst + 8, &nor, sizeof(nor));
+		memcpy(dst + 12, tex, sizeof(tex));
+	}
 
-	// Bind position buffer
-	h_pos = prog->getAttribute("vertPos");
-	GLSL::enableVertexAttribArray(h_pos);
-	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, posBufID));
-	CHECKED_GL_CALL(glVertexAttribPointer(h_pos, 3, GL_FLOAT, GL_FALSE, 0, (const void *)0));
+	indices.insert(indices.end(), eleBuf.begin(), eleBuf.end());
+}
+
+void Shape::setInstances(const vector<Instance> &instances)
+{
+	// Keep the full set for culling; the visible subset never outgrows it
+	allInstances = instances;
+	visibleInstances.reserve(instances.size());
 
-	// Bind normal buffer
-	h_nor = prog->getAttribute("vertNor");
-	if (h_nor != -1 && norBufID != 0)
+	if (instBufID == 0)
 	{
-		GLSL::enableVertexAttribArray(h_nor);
-		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, norBufID));
-		CHECKED_GL_CALL(glVertexAttribPointer(h_nor, 3, GL_FLOAT, GL_FALSE, 0, (const void *)0));
+		// The instance layout is fixed, so it is recorded in each VAO once
+		CHECKED_GL_CALL(glGenBuffers(1, &instBufID));
+		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+		CHECKED_GL_CALL(glBindVertexArray(vaoID));
+		recordInstanceLayout();
+		if (lineVaoID != 0)
+		{
+			CHECKED_GL_CALL(glBindVertexArray(lineVaoID));
+			recordInstanceLayout();
+		}
+		CHECKED_GL_CALL(glBindVertexArray(0));
 	}
 
-	if (texBufID != 0)
-	{
-		// Bind texcoords buffer
-		h_tex = prog->getAttribute("vertTex");
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, instances.size()*sizeof(Instance), instances.data(), GL_DYNAMIC_DRAW));
+	instanceCount = (int)instances.size();
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
 
-		if (h_tex != -1 && texBufID != 0)
+int Shape::cullInstances(const Frustum &frustum)
+{
+	visibleInstances.clear();
+	for (const Instance &inst : allInstances)
+	{
+		if (frustum.intersects(min, max, inst.M))
 		{
-			GLSL::enableVertexAttribArray(h_tex);
-			CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, texBufID));
-			CHECKED_GL_CALL(glVertexAttribPointer(h_tex, 2, GL_FLOAT, GL_FALSE, 0, (const void *)0));
+			visibleInstances.push_back(inst);
 		}
 	}
 
-	// Bind element buffer
-	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eleBufID));
+	instanceCount = (int)visibleInstances.size();
+	if (instanceCount > 0)
+	{
+		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+		CHECKED_GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount*sizeof(Instance), visibleInstances.data()));
+		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	}
+	return instanceCount;
+}
 
-	// Draw
-	CHECKED_GL_CALL(glDrawElements(GL_TRIANGLES, (int)eleBuf.size(), GL_UNSIGNED_INT, (const void *)0));
+// Expects the target VAO and the instance buffer to be bound
+void Shape::recordInstanceLayout() const
+{
+	for (int c = 0; c < 4; c++)
+	{
+		CHECKED_GL_CALL(glEnableVertexAttribArray(InstanceAttrib + c));
+		CHECKED_GL_CALL(glVertexAttribPointer(InstanceAttrib + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void *)(c * sizeof(glm::vec4))));
+		CHECKED_GL_CALL(glVertexAttribDivisor(InstanceAttrib + c, 1));
+	}
+	CHECKED_GL_CALL(glEnableVertexAttribArray(InstanceAttrib + 4));
+	CHECKED_GL_CALL(glVertexAttribIPointer(InstanceAttrib + 4, 1, GL_INT, sizeof(Instance), (const void *)offsetof(Instance, material)));
+	CHECKED_GL_CALL(glVertexAttribDivisor(InstanceAttrib + 4, 1));
+}
 
-	// Disable and unbind
-	if (h_tex != -1)
+void Shape::initNormalLines(int stride, float length)
+{
+	if (norBuf.empty())
 	{
-		GLSL::disableVertexAttribArray(h_tex);
+		return;
 	}
-	if (h_nor != -1)
+	stride = std::max(stride, 1);
+
+	// One segment per kept vertex, from the vertex along its unit normal
+	vector<float> lines;
+	lines.reserve(6 * (posBuf.size() / 3 / stride + 1));
+	for (size_t v = 0; v < posBuf.size() / 3; v += stride)
 	{
-		GLSL::disableVertexAttribArray(h_nor);
+		glm::vec3 p(posBuf[3*v+0], posBuf[3*v+1], posBuf[3*v+2]);
+		glm::vec3 n(norBuf[3*v+0], norBuf[3*v+1], norBuf[3*v+2]);
+		float len = glm::length(n);
+		glm::vec3 q = len > 0 ? p + n * (length / len) : p;
+		lines.insert(lines.end(), {p.x, p.y, p.z, q.x, q.y, q.z});
 	}
-	GLSL::disableVertexAttribArray(h_pos);
+	lineVertCount = (int)(lines.size() / 3);
+
+	if (lineVaoID == 0)
+	{
+		CHECKED_GL_CALL(glGenVertexArrays(1, &lineVaoID));
+		CHECKED_GL_CALL(glGenBuffers(1, &lineBufID));
+		CHECKED_GL_CALL(glBindVertexArray(lineVaoID));
+		CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, lineBufID));
+		CHECKED_GL_CALL(glEnableVertexAttribArray(PosAttrib));
+		CHECKED_GL_CALL(glVertexAttribPointer(PosAttrib, 3, GL_FLOAT, GL_FALSE, 0, (const void *)0));
+		if (instBufID != 0)
+		{
+			CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+			recordInstanceLayout();
+		}
+		CHECKED_GL_CALL(glBindVertexArray(0));
+	}
+
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, lineBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, lines.size()*sizeof(float), lines.data(), GL_STATIC_DRAW));
 	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+}
+
+void Shape::draw() const
+{
+	drawElements(0);
+}
+
+void Shape::drawInstanced() const
+{
+	if (instanceCount > 0)
+	{
+		drawElements(instanceCount);
+	}
+}
+
+// All attribute state lives in the VAO, so a draw is a bind plus the draw call
+void Shape::drawElements(int instances) const
+{
+	// Position dequantization is per shape, so it travels as generic attribute values
+	CHECKED_GL_CALL(glVertexAttrib3f(PosScaleAttrib, posScale.x, posScale.y, posScale.z));
+	CHECKED_GL_CALL(glVertexAttrib3f(PosBiasAttrib, posBias.x, posBias.y, posBias.z));
+
+	CHECKED_GL_CALL(glBindVertexArray(vaoID));
+	if (instances > 0)
+	{
+		CHECKED_GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, (int)eleBuf.size(), eleType, (const void *)0, instances));
+	}
+	else
+	{
+		CHECKED_GL_CALL(glDrawElements(GL_TRIANGLES, (int)eleBuf.size(), eleType, (const void *)0));
+	}
+}
+
+void Shape::drawNormalLines() const
+{
+	drawLines(0);
+}
+
+void Shape::drawNormalLinesInstanced() const
+{
+	if (instanceCount > 0)
+	{
+		drawLines(instanceCount);
+	}
+}
+
+void Shape::drawLines(int instances) const
+{
+	if (lineVaoID == 0)
+	{
+		return;
+	}
+
+	CHECKED_GL_CALL(glBindVertexArray(lineVaoID));
+	if (instances > 0)
+	{
+		CHECKED_GL_CALL(glDrawArraysInstanced(GL_LINES, 0, lineVertCount, instances));
+	}
+	else
+	{
+		CHECKED_GL_CALL(glDrawArrays(GL_LINES, 0, lineVertCount));
+	}
 }
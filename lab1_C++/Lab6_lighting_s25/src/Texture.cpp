@@ -5,12 +5,14 @@
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "TextureCache.h"
 
 using namespace std;
 
 Texture::Texture() :
 	filename(""),
-	tid(0)
+	tid(0),
+	ready(false)
 {
 	
 }
@@ -22,31 +24,19 @@ Texture::~Texture()
 
 void Texture::init()
 {
-	// Load texture
-	int w, h, ncomps;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char *data = stbi_load(filename.c_str(), &w, &h, &ncomps, 0);
-	if(!data) {
+	// Load the cooked mip chain (decoding and cooking the source on first use)
+	TextureCache::Image image;
+	if (!TextureCache::load(filename, image)) {
 		cerr << filename << " not found" << endl;
 	}
-	if(ncomps != 3) {
-		cerr << filename << " must have 3 components (RGB)" << endl;
+	if (image.cooked) {
+		cout << filename << " cooked to " << image.width() << "x" << image.height() << " with " << image.levels.size() << " levels" << endl;
 	}
-	if((w & (w - 1)) != 0 || (h & (h - 1)) != 0) {
-		cerr << filename << " must be a power of 2" << endl;
-	}
-	width = w;
-	height = h;
 
 	// Generate a texture buffer object
 	glGenTextures(1, &tid);
 	// Bind the current texture to be the newly generated texture object
 	glBindTexture(GL_TEXTURE_2D, tid);
-	// Load the actual texture data
-	// Base level is 0, number of channels is 3, and border is 0.
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-	// Generate image pyramid
-	glGenerateMipmap(GL_TEXTURE_2D);
 	// Set texture wrap modes for the S and T directions
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -55,8 +45,52 @@ void Texture::init()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	// Unbind
 	glBindTexture(GL_TEXTURE_2D, 0);
-	// Free image, since the data is now on the GPU
-	stbi_image_free(data);
+	// Upload every level straight from the mapped file
+	uploadLevels(image, image.pixels());
+}
+
+void Texture::initPlaceholder(unsigned char r, unsigned char g, unsigned char b)
+{
+	unsigned char texel[3] = {r, g, b};
+	width = 1;
+	height = 1;
+
+	glGenTextures(1, &tid);
+	glBindTexture(GL_TEXTURE_2D, tid);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// Same sampling state as init(), so setWrapModes() and later uploads keep working
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	ready = false;
+}
+
+void Texture::uploadLevels(const TextureCache::Image &image, const unsigned char *pixels)
+{
+	if (image.levels.empty()) {
+		return;
+	}
+	GLenum format = image.components == 4 ? GL_RGBA : GL_RGB;
+	width = image.width();
+	height = image.height();
+
+	// The levels are precomputed, so no glGenerateMipmap; with a pixel buffer
+	// bound the copies are queued and this returns without waiting
+	glBindTexture(GL_TEXTURE_2D, tid);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t i = 0; i < image.levels.size(); i++) {
+		const TextureCache::Level &level = image.levels[i];
+		const void *src = pixels ? (const void *)(pixels + level.offset) : (const void *)level.offset;
+		glTexImage2D(GL_TEXTURE_2D, (GLint)i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, src);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	ready = true;
 }
 
 void Texture::setWrapModes(GLint wrapS, GLint wrapT)
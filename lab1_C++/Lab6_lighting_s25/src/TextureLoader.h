@@ -0,0 +1,67 @@
+#pragma once
+#ifndef LAB471_TEXTURELOADER_H_INCLUDED
+#define LAB471_TEXTURELOADER_H_INCLUDED
+
+#include <glad/glad.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TextureCache.h"
+
+class Texture;
+
+
+// Loads cooked texture mip chains (see TextureCache) on worker threads and
+// uploads them from the render thread through a pixel buffer object, one per
+// frame. Textures show a placeholder until their image is on the GPU.
+class TextureLoader
+{
+
+public:
+
+	// threads = 0 picks a count from the hardware (at most 4)
+	explicit TextureLoader(int threads = 0);
+	~TextureLoader();
+
+	// Creates the placeholder now (needs the GL context) and queues the decode
+	void load(const std::shared_ptr<Texture> &texture);
+
+	// Render thread, once per frame: uploads at most one decoded image
+	void update();
+
+	// True while any queued texture is not on the GPU yet
+	bool busy() const;
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Job
+	{
+		std::shared_ptr<Texture> texture;
+		Clock::time_point requested;
+		TextureCache::Image image;
+		bool loaded = false;
+		double loadMs = 0.0;
+	};
+
+	void work();
+
+	std::vector<std::thread> workers;
+	std::deque<Job> pending;
+	std::deque<Job> decoded;
+	mutable std::mutex queueMutex;
+	std::condition_variable wake;
+	bool quit = false;
+	int outstanding = 0;
+
+	GLuint pbo = 0;
+
+};
+
+#endif // LAB471_TEXTURELOADER_H_INCLUDED
@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef LAB471_UNIFORM_H_INCLUDED
+#define LAB471_UNIFORM_H_INCLUDED
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLSL.h"
+
+
+// Typed uniform location, resolved once by Program::uniform<T>() at init so
+// the frame loop never looks uniforms up by name
+template <typename T>
+class Uniform
+{
+
+public:
+
+	Uniform() {}
+	explicit Uniform(GLint location) : location(location) {}
+
+	void set(const T &value) const;
+	GLint getLocation() const { return location; }
+
+private:
+
+	GLint location = -1;
+
+};
+
+template <>
+inline void Uniform<int>::set(const int &value) const
+{
+	CHECKED_GL_CALL(glUniform1i(location, value));
+}
+
+template <>
+inline void Uniform<float>::set(const float &value) const
+{
+	CHECKED_GL_CALL(glUniform1f(location, value));
+}
+
+template <>
+inline void Uniform<glm::vec2>::set(const glm::vec2 &value) const
+{
+	CHECKED_GL_CALL(glUniform2fv(location, 1, glm::value_ptr(value)));
+}
+
+template <>
+inline void Uniform<glm::vec3>::set(const glm::vec3 &value) const
+{
+	CHECKED_GL_CALL(glUniform3fv(location, 1, glm::value_ptr(value)));
+}
+
+template <>
+inline void Uniform<glm::mat4>::set(const glm::mat4 &value) const
+{
+	CHECKED_GL_CALL(glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)));
+}
+
+#endif // LAB471_UNIFORM_H_INCLUDED
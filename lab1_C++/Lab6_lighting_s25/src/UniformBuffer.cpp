@@ -0,0 +1,28 @@
+#include "UniformBuffer.h"
+#include <cassert>
+
+#include "GLSL.h"
+
+
+void UniformBuffer::init(GLsizeiptr size, GLuint binding)
+{
+	this->size = size;
+	this->binding = binding;
+
+	CHECKED_GL_CALL(glGenBuffers(1, &bufID));
+	CHECKED_GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, bufID));
+	CHECKED_GL_CALL(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+	CHECKED_GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+
+	// The binding stays in place for the lifetime of the buffer
+	CHECKED_GL_CALL(glBindBufferBase(GL_UNIFORM_BUFFER, binding, bufID));
+}
+
+void UniformBuffer::update(const void *data, GLsizeiptr size, GLintptr offset) const
+{
+	assert(offset + size <= this->size);
+
+	CHECKED_GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, bufID));
+	CHECKED_GL_CALL(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+	CHECKED_GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
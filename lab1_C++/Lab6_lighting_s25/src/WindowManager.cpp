@@ -30,7 +30,7 @@ WindowManager::~WindowManager()
 	}
 }
 
-bool WindowManager::init(int const width, int const height)
+bool WindowManager::init(int const width, int const height, bool const visible)
 {
 	glfwSetErrorCallback(error_callback);
 
@@ -45,6 +45,10 @@ bool WindowManager::init(int const width, int const height)
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+#ifdef GL_ERROR_CHECKS_CALLBACK
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
 	// Create a windowed mode window and its OpenGL context.
 	windowHandle = glfwCreateWindow(width, height, "hello 3D", nullptr, nullptr);
@@ -65,9 +69,10 @@ bool WindowManager::init(int const width, int const height)
 
 	std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
 	std::cout << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+	GLSL::enableDebugOutput();
 
-	// Set vsync
-	glfwSwapInterval(1);
+	// Set vsync (nothing is presented when hidden)
+	glfwSwapInterval(visible ? 1 : 0);
 
 	glfwSetKeyCallback(windowHandle, key_callback);
 	glfwSetMouseButtonCallback(windowHandle, mouse_callback);
@@ -53,7 +53,8 @@ public:
 	WindowManager(const WindowManager&) = delete;
 	WindowManager& operator= (const WindowManager&) = delete;
 
-	bool init(int const width, int const height);
+	// A hidden window only provides the GL context (see Headless)
+	bool init(int const width, int const height, bool const visible = true);
 	void shutdown();
 
 	void setEventCallbacks(EventCallbacks *callbacks);
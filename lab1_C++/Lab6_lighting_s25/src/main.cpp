@@ -5,6 +5,14 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <glad/glad.h>
 
 #include "GLSL.h"
@@ -13,6 +21,16 @@
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "UniformBuffer.h"
+#include "MaterialRegistry.h"
+#include "OutlinePass.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include "Headless.h"
+#include "FrameCapture.h"
+#include "RenderQueue.h"
+#include "MeshPool.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader/tiny_obj_loader.h>
@@ -40,9 +58,60 @@ public:
 	//Shader program for outline
 	std::shared_ptr<Program> outProg;
 
-	//Shader program for geometric shader
+	//Shader program for the surface normal lines
 	std::shared_ptr<Program> geoProg;
 
+	//per-frame camera and light data, matches the std140 Frame block in the shaders
+	struct FrameData
+	{
+		mat4 P;
+		mat4 V;
+		vec4 lightPos;
+	};
+	static const GLuint FrameBinding = 0;
+	UniformBuffer frameUBO;
+
+	//every material in one uniform buffer, selected by index per draw/instance
+	static const GLuint MaterialBinding = 1;
+	MaterialRegistry materials;
+
+	//screen-space outline (toggle with O) instead of the inflated back-face pass
+	OutlinePass outlinePass;
+	bool gScreenOutline = false;
+
+	//uniform handles resolved once in init()
+	Uniform<mat4> progM, outM, texM, geoM;
+
+	//matrix stacks live for the whole run and are reset each frame (no per-frame allocation)
+	shared_ptr<MatrixStack> Projection = make_shared<MatrixStack>();
+	shared_ptr<MatrixStack> View = make_shared<MatrixStack>();
+	shared_ptr<MatrixStack> Model = make_shared<MatrixStack>();
+
+	//camera frustum for CPU culling, and last frame's submitted/culled object counts
+	Frustum frustum;
+	int gSubmitted = -1;
+	int gCulled = -1;
+
+	//per-pass CPU/GPU timings (--profile), optionally drawn as bars (P)
+	Profiler profiler;
+
+	//draws are queued each frame and issued sorted by pass, program, material and texture
+	RenderQueue renderQueue;
+	int passOutline, passCel, passGround, passNormals;
+	//draw calls for the queue, built once in init()
+	RenderQueue::Call drawPooled, drawGroundPlane, drawDragonNormals;
+
+	//the dragon and sphere share buffers; the outline and cel passes each draw them with one multi-draw
+	MeshPool meshPool;
+	int sphereMesh, dragonMesh;
+
+	//frame recording (C or --capture): <prefix>NNNN.png, read back and encoded off the render thread
+	FrameCapture capture;
+	bool gCapturing = false;
+	std::string gCapturePrefix = "capture_";
+	int gCaptureFrame = 0;
+	Uniform<int> texSampler;
+
 	//our geometry
 	shared_ptr<Shape> sphere;
 
@@ -53,9 +122,14 @@ public:
 	int g_GiboLen;
 	//ground VAO
 	GLuint GroundVertexArrayID;
+	//object-space bounds and placement of the ground quad (for culling)
+	vec3 gGroundMin, gGroundMax;
+	mat4 gGroundM = glm::translate(mat4(1.0f), vec3(0, -1, 0));
 
 	//the image to use as a texture (ground)
 	shared_ptr<Texture> texture0;
+	//decodes textures in the background; the ground shows a grey placeholder until then
+	TextureLoader textureLoader;
 
 	//global data (larger program should be encapsulated)
 	vec3 gMin;
@@ -63,10 +137,19 @@ public:
 	float gCamH = 0;
 	//animation data
 	float lightTrans = 0;
+	//world-space light position shared through the Frame block
+	vec3 gLightPos = vec3(0);
 	float gTrans = -3;
 	float sTheta = 0;
 	float eTheta = 0;
 	float hTheta = 0;
+	//animation clock override (headless runs use a fixed per-frame time)
+	double gFixedTime = -1;
+	//dragons per side of the instanced grid
+	int gGridDim = 3;
+	//normal lines: every gNormalStride-th vertex, gNormalLength long (object space)
+	int gNormalStride = 1;
+	float gNormalLength = 0.005f;
 
 	void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
 	{
@@ -95,6 +178,18 @@ public:
 		if (key == GLFW_KEY_E && action == GLFW_PRESS){
 			lightTrans -= 0.25;
 		}
+		if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+			gScreenOutline = !gScreenOutline;
+		}
+		if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+			profiler.setOverlay(!profiler.hasOverlay());
+		}
+		if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+			gCapturing = !gCapturing;
+			if (!gCapturing) {
+				capture.finish();
+			}
+		}
 		if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
 			glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 		}
@@ -133,14 +228,9 @@ public:
 		prog->setVerbose(true);
 		prog->setShaderNames(resourceDirectory + "/cel_vert.glsl", resourceDirectory + "/cel_frag.glsl", "");
 		prog->init();
-		prog->addUniform("P");
-		prog->addUniform("V");
-		prog->addUniform("M");
-		prog->addUniform("MatAmb");
-		prog->addUniform("MatDif");
-		prog->addUniform("MatSpec");
-		prog->addUniform("MatShine");
-		prog->addUniform("lightPos");
+		prog->bindUniformBlock("Frame", FrameBinding);
+		prog->bindUniformBlock("Materials", MaterialBinding);
+		progM = prog->uniform<mat4>("M");
 		prog->addAttribute("vertPos");
 		prog->addAttribute("vertNor");
 
@@ -148,9 +238,8 @@ public:
 		outProg->setVerbose(true);
 		outProg->setShaderNames(resourceDirectory + "/outline_vert.glsl", resourceDirectory + "/outline_frag.glsl", "");
 		outProg->init();
-		outProg->addUniform("P");
-		outProg->addUniform("V");
-		outProg->addUniform("M");
+		outProg->bindUniformBlock("Frame", FrameBinding);
+		outM = outProg->uniform<mat4>("M");
 		outProg->addAttribute("vertPos");
 		outProg->addAttribute("vertNor");
 
@@ -159,30 +248,32 @@ public:
 		texProg->setVerbose(true);
 		texProg->setShaderNames(resourceDirectory + "/tex_vert.glsl", resourceDirectory + "/tex_frag0.glsl", "");
 		texProg->init();
-		texProg->addUniform("P");
-		texProg->addUniform("V");
-		texProg->addUniform("M");
-		texProg->addUniform("Texture0");
+		texProg->bindUniformBlock("Frame", FrameBinding);
+		texM = texProg->uniform<mat4>("M");
+		texSampler = texProg->uniform<int>("Texture0");
 		texProg->addAttribute("vertPos");
 		texProg->addAttribute("vertNor");
 		texProg->addAttribute("vertTex");
 
-		// Initialize geometric shader program
+		// Initialize the normal line program (lines are prebuilt per mesh)
 		geoProg = make_shared<Program>();
 		geoProg->setVerbose(true);
-		geoProg->setShaderNames(resourceDirectory + "/geom_vert.glsl", resourceDirectory + "/geom_frag.glsl", resourceDirectory + "/geom_sh.glsl");
+		geoProg->setShaderNames(resourceDirectory + "/normal_vert.glsl", resourceDirectory + "/geom_frag.glsl", "");
 		geoProg->init();
-		geoProg->addUniform("P");
-		geoProg->addUniform("V");
-		geoProg->addUniform("M");
+		geoProg->bindUniformBlock("Frame", FrameBinding);
+		geoM = geoProg->uniform<mat4>("M");
 		geoProg->addAttribute("vertPos");
-		geoProg->addAttribute("vertNor");
 		
 
+		frameUBO.init(sizeof(FrameData), FrameBinding);
+		initMaterials();
+		outlinePass.init(resourceDirectory, FrameBinding);
+		initRenderQueue();
+
 		//read in a load the texture
 		texture0 = make_shared<Texture>();
   		texture0->setFilename(resourceDirectory + "/texture.jpg");
-  		texture0->init();
+  		textureLoader.load(texture0);
   		texture0->setUnit(0);
   		texture0->setWrapModes(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 	}
@@ -202,9 +293,11 @@ public:
 			cerr << errStr << endl;
 		} else {
 			sphere = make_shared<Shape>();
-			sphere->createShape(TOshapes[0]);
+			sphere->createShape(std::move(TOshapes[0]));
+			sphere->optimize();
 			sphere->measure();
-			sphere->init();
+			//drawn only through the pool, so the shape needs no buffers of its own
+			sphereMesh = meshPool.add(*sphere);
 		}
 		//read out information stored in the shape about its size - something like this...
 		//then do something with that information.....
@@ -221,13 +314,41 @@ public:
 		} else {
 			
 			theDragon = make_shared<Shape>();
-			theDragon->createShape(TOshapesB[0]);
+			theDragon->createShape(std::move(TOshapesB[0]));
+			theDragon->optimize();
 			theDragon->measure();
+			//its own buffers hold the normal lines and the culled instance set
 			theDragon->init();
+			theDragon->initNormalLines(gNormalStride, gNormalLength);
+			dragonMesh = meshPool.add(*theDragon);
+			initDragonGrid();
 		}
 
 		//code to load in the ground plane (CPU defined data passed to GPU)
 		initGround();
+
+		//upload the pooled meshes in one set of buffers
+		meshPool.init();
+	}
+
+	//lay out the dragon grid once as per-instance transforms and materials
+	void initDragonGrid() {
+		Model->reset();
+		vector<Shape::Instance> grid;
+		grid.reserve(gGridDim*gGridDim);
+
+		float sp = 3.0;
+		float off = -0.5 - sp*(gGridDim-1)/2.0;
+		for (int i =0; i < gGridDim; i++) {
+			for (int j=0; j < gGridDim; j++) {
+				Model->pushMatrix();
+					Model->translate(vec3(off+sp*i, -1, off+sp*j));
+					Model->scale(vec3(0.85, 0.85, 0.85));
+					grid.push_back({Model->topMatrix(), (i+j)%3});
+				Model->popMatrix();
+			}
+		}
+		theDragon->setInstances(grid);
 	}
 
 	//directly pass quad for the ground to the GPU
@@ -243,6 +364,8 @@ public:
 			g_groundSize, g_groundY,  g_groundSize,
 			g_groundSize, g_groundY, -g_groundSize
 		};
+		gGroundMin = vec3(-g_groundSize, g_groundY, -g_groundSize);
+		gGroundMax = vec3(g_groundSize, g_groundY, g_groundSize);
 
 		float GrndNorm[] = {
 			0, 1, 0,
@@ -269,90 +392,94 @@ public:
       	glGenBuffers(1, &GrndBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndPos), GrndPos, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(0);
+      	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GrndNorBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndNorBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndNorm), GrndNorm, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(1);
+      	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GrndTexBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndTexBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndTex), GrndTex, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(2);
+      	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GIndxBuffObj);
      	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GIndxBuffObj);
       	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+      	glBindVertexArray(0);
       }
 
-      //code to draw the ground plane
-     void drawGround(shared_ptr<Program> curS) {
-     	curS->bind();
+      //code to draw the ground plane (the render queue binds the program, texture and gGroundM)
+     void drawGround() {
      	glBindVertexArray(GroundVertexArrayID);
-     	texture0->bind(curS->getUniform("Texture0"));
-		//draw the ground plane 
-  		SetModel(vec3(0, -1, 0), 0, 0, 1, curS);
-  		glEnableVertexAttribArray(0);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndBuffObj);
-  		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-  		glEnableVertexAttribArray(1);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndNorBuffObj);
-  		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-  		glEnableVertexAttribArray(2);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndTexBuffObj);
-  		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-   		// draw!
-  		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GIndxBuffObj);
+   		// draw! (attribute layout is recorded in the ground VAO)
   		glDrawElements(GL_TRIANGLES, g_GiboLen, GL_UNSIGNED_SHORT, 0);
-
-  		glDisableVertexAttribArray(0);
-  		glDisableVertexAttribArray(1);
-  		glDisableVertexAttribArray(2);
-  		curS->unbind();
      }
 
-     //helper function to pass material data to the GPU
-	void SetMaterial(shared_ptr<Program> curS, int i) {
-
-    	switch (i) {
-    		case 0: //
-    			glUniform3f(curS->getUniform("MatAmb"), 0.096, 0.046, 0.095);
-    			glUniform3f(curS->getUniform("MatDif"), 0.96, 0.46, 0.95);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.45, 0.23, 0.45);
-    			glUniform1f(curS->getUniform("MatShine"), 120.0);
-    		break;
-    		case 1: // 
-    			glUniform3f(curS->getUniform("MatAmb"), 0.063, 0.038, 0.1);
-    			glUniform3f(curS->getUniform("MatDif"), 0.63, 0.38, 1.0);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.3, 0.2, 0.5);
-    			glUniform1f(curS->getUniform("MatShine"), 4.0);
-    		break;
-    		case 2: //
-    			glUniform3f(curS->getUniform("MatAmb"), 0.004, 0.05, 0.09);
-    			glUniform3f(curS->getUniform("MatDif"), 0.04, 0.5, 0.9);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.02, 0.25, 0.45);
-    			glUniform1f(curS->getUniform("MatShine"), 27.9);
-    		break;
-  		}
+	//passes in drawing order, and the draw calls the frame submits
+	void initRenderQueue() {
+		//inflated back faces behind the dragons
+		passOutline = renderQueue.addPass("outline", [] { glCullFace(GL_FRONT); }, [] { glCullFace(GL_BACK); });
+		passCel = renderQueue.addPass("cel");
+		//ground and normal lines are not outlined by the screen-space pass
+		auto noNormals = [this] { if (gScreenOutline) outlinePass.writeNormals(false); };
+		passGround = renderQueue.addPass("ground", noNormals);
+		passNormals = renderQueue.addPass("normals", noNormals);
+
+		drawPooled = [this] { meshPool.draw(); };
+		drawGroundPlane = [this] { drawGround(); };
+		drawDragonNormals = [this] { theDragon->drawNormalLinesInstanced(); };
+	}
+
+	//queue a draw of call with prog, uploading model through M
+	void submit(int pass, const shared_ptr<Program> &prog, const Uniform<mat4> &M, const mat4 &model,
+		const RenderQueue::Call &call, int material = -1) {
+		RenderQueue::Draw draw;
+		draw.pass = pass;
+		draw.program = prog.get();
+		draw.material = material;
+		draw.modelUniform = M;
+		draw.model = model;
+		draw.call = &call;
+		renderQueue.submit(draw);
+	}
+
+     //register the scene materials (indices 0-2 are used by the dragon grid)
+	void initMaterials() {
+		//shiny blue plastic
+		materials.add(vec3(0.096, 0.046, 0.095), vec3(0.96, 0.46, 0.95), vec3(0.45, 0.23, 0.45), 120.0);
+		// flat grey
+		materials.add(vec3(0.063, 0.038, 0.1), vec3(0.63, 0.38, 1.0), vec3(0.3, 0.2, 0.5), 4.0);
+		//brass
+		materials.add(vec3(0.004, 0.05, 0.09), vec3(0.04, 0.5, 0.9), vec3(0.02, 0.25, 0.45), 27.9);
+		materials.init(MaterialBinding);
 	}
 
 	/* helper function to set model trasnforms */
-  	void SetModel(vec3 trans, float rotY, float rotX, float sc, shared_ptr<Program> curS) {
+  	void SetModel(vec3 trans, float rotY, float rotX, float sc, const Uniform<mat4> &M) {
   		mat4 Trans = glm::translate( glm::mat4(1.0f), trans);
   		mat4 RotX = glm::rotate( glm::mat4(1.0f), rotX, vec3(1, 0, 0));
   		mat4 RotY = glm::rotate( glm::mat4(1.0f), rotY, vec3(0, 1, 0));
   		mat4 ScaleS = glm::scale(glm::mat4(1.0f), vec3(sc));
   		mat4 ctm = Trans*RotX*RotY*ScaleS;
-  		glUniformMatrix4fv(curS->getUniform("M"), 1, GL_FALSE, value_ptr(ctm));
+  		M.set(ctm);
   	}
 
-	void setModel(std::shared_ptr<Program> prog, std::shared_ptr<MatrixStack>M) {
-		glUniformMatrix4fv(prog->getUniform("M"), 1, GL_FALSE, value_ptr(M->topMatrix()));
-   	}
+	//print the submitted vs culled object counts whenever they change
+	void reportCulling(int submitted, int total) {
+		if (submitted != gSubmitted || total - submitted != gCulled) {
+			gSubmitted = submitted;
+			gCulled = total - submitted;
+			cout << "objects submitted " << gSubmitted << " culled " << gCulled << endl;
+		}
+	}
 
    	/* code to draw waving hierarchical model */
-   	void drawHierModel(shared_ptr<MatrixStack> Model, bool outline, bool geo) {
+   	void drawHierModel(shared_ptr<MatrixStack> Model) {
    		// draw hierarchical mesh - replace with your code if desired
 		Model->pushMatrix();
 			Model->loadIdentity();
@@ -361,22 +488,20 @@ public:
 			//draw the torso with these transforms
 			Model->pushMatrix();
 			  Model->scale(vec3(1.15, 1.35, 1.0));
-			  if(outline){
-				setModel(outProg, Model);
-			  }
-			  else if(geo){
-				setModel(geoProg, Model);
-			  }
-			  else{
-				setModel(prog, Model);
-			  }
-			  // sphere->draw(prog);
+			  // meshPool.submit(sphereMesh, Model->topMatrix(), 1);
 			Model->popMatrix();
 			
 		Model->popMatrix();
    	}
 
 	void render() {
+		profiler.beginFrame();
+
+		// Finish at most one background texture load per frame
+		profiler.begin("upload");
+		textureLoader.update();
+		profiler.end();
+
 		// Get current frame buffer size.
 		int width, height;
 		glfwGetFramebufferSize(windowManager->getHandle(), &width, &height);
@@ -388,10 +513,10 @@ public:
 		//Use the matrix stack for Lab 6
 		float aspect = width/(float)height;
 
-		// Create the matrix stacks - please leave these alone for now
-		auto Projection = make_shared<MatrixStack>();
-		auto View = make_shared<MatrixStack>();
-		auto Model = make_shared<MatrixStack>();
+		// Start the matrix stacks from identity - please leave these alone for now
+		Projection->reset();
+		View->reset();
+		Model->reset();
 
 		// Apply perspective projection.
 		Projection->pushMatrix();
@@ -405,114 +530,83 @@ public:
 		//global rotate (the whole scene )
 		View->rotate(gRot, vec3(0, 1, 0));
 
-		// Use outline shader
-		outProg->bind();
-		glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);
-		glUniformMatrix4fv(outProg->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(outProg->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		// glUniform3f(outProg->getUniform("lightPos"), 2.0, 2.0, 2.9);
+		// Camera and light go to the shared Frame block once for all programs
+		FrameData frame = {Projection->topMatrix(), View->topMatrix(), vec4(gLightPos, 1.0)};
+		frameUBO.update(frame);
 
-		// draw the array of dragons
-		Model->pushMatrix();
+		// Cull once per frame; every pass below draws only the visible dragons
+		frustum.extract(Projection->topMatrix() * View->topMatrix());
+		int visibleDragons = theDragon->cullInstances(frustum);
+		bool groundVisible = frustum.intersects(gGroundMin, gGroundMax, gGroundM);
+		reportCulling(visibleDragons + (groundVisible ? 1 : 0), gGridDim*gGridDim + 1);
 
-		float sp = 3.0;
-		float off = -3.5;
-		  for (int i =0; i < 3; i++) {
-		  	for (int j=0; j < 3; j++) {
-			  Model->pushMatrix();
-				Model->translate(vec3(off+sp*i, -1, off+sp*j));
-				Model->scale(vec3(0.85, 0.85, 0.85));
-				// SetMaterial(outProg, (i+j)%3);
-				glUniformMatrix4fv(outProg->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-				theDragon->draw(outProg);
-			  Model->popMatrix();
-			}
-		  }
-		Model->popMatrix();
-
-		//draw the waving HM
-		// SetMaterial(outProg, 1);
-		drawHierModel(Model, true, false);
-		glCullFace(GL_BACK);
-		outProg->unbind();
-
-		// Draw the scene
-		prog->bind();
-		glUniformMatrix4fv(prog->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(prog->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		// glUniform3f(prog->getUniform("lightPos"), 2.0, 2.0, 2.9);
-
-		// draw the array of dragons
-		Model->pushMatrix();
-
-		  for (int i =0; i < 3; i++) {
-		  	for (int j=0; j < 3; j++) {
-			  Model->pushMatrix();
-				Model->translate(vec3(off+sp*i, -1, off+sp*j));
-				Model->scale(vec3(0.85, 0.85, 0.85));
-				SetMaterial(prog, (i+j)%3);
-				glUniformMatrix4fv(prog->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-				theDragon->draw(prog);
-			  Model->popMatrix();
-			}
-		  }
-		Model->popMatrix();
-
-		//draw the waving HM
-		SetMaterial(prog, 1);
-		drawHierModel(Model, false, false);
+		glEnable(GL_CULL_FACE);
+		if (gScreenOutline) {
+			// outlines come from the post-process, so draw the scene once into its FBO
+			outlinePass.begin(width, height);
+		}
 
-		prog->unbind();
+		// the array of dragons and the waving HM go to the mesh pool once for both passes
+		meshPool.clear();
+		meshPool.submit(dragonMesh, theDragon->getVisibleInstances());
+		drawHierModel(Model);
+		meshPool.upload();
+
+		// Queue the scene; the queue sorts it and skips state that is already bound
+		renderQueue.begin(View->topMatrix());
+		if (!gScreenOutline) {
+			// outlined
+			submit(passOutline, outProg, outM, Model->topMatrix(), drawPooled);
+		}
 
-		//switch shaders to the texture mapping shader and draw the ground
-		texProg->bind();
-		glUniformMatrix4fv(texProg->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(texProg->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		glUniformMatrix4fv(texProg->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-				
-		drawGround(texProg);
+		// Draw the scene with the cel shader
+		submit(passCel, prog, progM, Model->topMatrix(), drawPooled);
+
+		//the ground with the texture mapping shader
+		if (groundVisible) {
+			RenderQueue::Draw ground;
+			ground.pass = passGround;
+			ground.program = texProg.get();
+			ground.texture = texture0.get();
+			ground.sampler = texSampler;
+			ground.modelUniform = texM;
+			ground.model = gGroundM;
+			ground.call = &drawGroundPlane;
+			renderQueue.submit(ground);
+		}
 
-		texProg->unbind();
+		// the surface normals of the dragon array (one instanced draw) with the line shader
+		submit(passNormals, geoProg, geoM, Model->topMatrix(), drawDragonNormals);
 
-		// Switch to the geometric shader to draw the surface normals
-		geoProg->bind();
-		
-		glUniformMatrix4fv(geoProg->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(geoProg->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		// glUniform3f(outProg->getUniform("lightPos"), 2.0, 2.0, 2.9);
+		renderQueue.execute(&profiler);
+		renderQueue.reportChanges();
 
-		// draw the array of dragons
-		Model->pushMatrix();
+		if (gScreenOutline) {
+			profiler.begin("outline");
+			outlinePass.end();
+			profiler.end();
+		}
 
-		  for (int i =0; i < 3; i++) {
-		  	for (int j=0; j < 3; j++) {
-			  Model->pushMatrix();
-				Model->translate(vec3(off+sp*i, -1, off+sp*j));
-				Model->scale(vec3(0.85, 0.85, 0.85));
-				// SetMaterial(outProg, (i+j)%3);
-				glUniformMatrix4fv(geoProg->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-				theDragon->draw(geoProg);
-			  Model->popMatrix();
-			}
-		  }
-		Model->popMatrix();
+		profiler.drawOverlay(width, height);
 
-		//draw the waving HM
-		// SetMaterial(outProg, 1);
-		drawHierModel(Model, false, true);
-		geoProg->unbind();
+		if (gCapturing) {
+			char number[16];
+			snprintf(number, sizeof(number), "%04d", gCaptureFrame++);
+			capture.capture(gCapturePrefix + number + ".png", width, height);
+		}
 
 		
 		//animation update example
-		sTheta = sin(glfwGetTime());
-		eTheta = std::max(0.0f, (float)sin(glfwGetTime()));
-		hTheta = std::max(0.0f, (float)cos(glfwGetTime()));
+		double time = gFixedTime >= 0 ? gFixedTime : glfwGetTime();
+		sTheta = sin(time);
+		eTheta = std::max(0.0f, (float)sin(time));
+		hTheta = std::max(0.0f, (float)cos(time));
 
 		// Pop matrix stacks.
 		Projection->popMatrix();
 		View->popMatrix();
 
+		profiler.endFrame();
 	}
 };
 
@@ -520,19 +614,94 @@ int main(int argc, char *argv[])
 {
 	// Where the resources are loaded from
 	std::string resourceDir = "../resources";
+	Application *application = new Application();
+
+	// Profiling flags may appear anywhere; the rest are positional
+	//   --profile             print per-pass CPU/GPU averages every 60 frames
+	//   --profile-csv <file>  also write every sample to a CSV file
+	//   --profile-overlay     start with the timing bars on screen (toggle with P)
+	// Headless benchmarking (hidden window, offscreen framebuffer, fixed clock)
+	//   --headless <frames>   render this many frames, print frame time statistics and exit
+	//   --size <w>x<h>        resolution (default 640x480)
+	//   --dump <prefix>       save the last frame as <prefix>NNNN.png
+	//   --dump-every <n>      save every n-th frame instead
+	// Recording in either mode (also toggled with C)
+	//   --capture <prefix>    save every frame as <prefix>NNNN.png
+	// Mesh pool
+	//   --no-indirect         draw pooled meshes one command at a time, as without GL 4.3
+	Headless headless;
+	std::string dumpPrefix;
+	int dumpEvery = 0;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--profile")
+		{
+			application->profiler.setEnabled(true);
+		}
+		else if (arg == "--profile-csv" && i + 1 < argc)
+		{
+			if (application->profiler.openCsv(argv[++i]))
+			{
+				application->profiler.setEnabled(true);
+			}
+		}
+		else if (arg == "--profile-overlay")
+		{
+			application->profiler.setOverlay(true);
+		}
+		else if (arg == "--headless" && i + 1 < argc)
+		{
+			headless.setFrames(atoi(argv[++i]));
+		}
+		else if (arg == "--size" && i + 1 < argc)
+		{
+			int w = 0, h = 0;
+			if (sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+			{
+				headless.setSize(w, h);
+			}
+		}
+		else if (arg == "--dump" && i + 1 < argc)
+		{
+			dumpPrefix = argv[++i];
+		}
+		else if (arg == "--dump-every" && i + 1 < argc)
+		{
+			dumpEvery = std::max(0, atoi(argv[++i]));
+		}
+		else if (arg == "--capture" && i + 1 < argc)
+		{
+			application->gCapturePrefix = argv[++i];
+			application->gCapturing = true;
+		}
+		else if (arg == "--no-indirect")
+		{
+			application->meshPool.setIndirect(false);
+		}
+		else
+		{
+			args.push_back(arg);
+		}
+	}
 
-	if (argc >= 2)
+	if (args.size() >= 1)
 	{
-		resourceDir = argv[1];
+		resourceDir = args[0];
 	}
 
-	Application *application = new Application();
+	// Optional size of the instanced dragon grid (per side)
+	if (args.size() >= 2)
+	{
+		application->gGridDim = std::max(1, atoi(args[1].c_str()));
+	}
 
 	// Your main will always include a similar set up to establish your window
 	// and GL context, etc.
 
 	WindowManager *windowManager = new WindowManager();
-	windowManager->init(640, 480);
+	windowManager->init(headless.getWidth(), headless.getHeight(), !headless.isEnabled());
 	windowManager->setEventCallbacks(application);
 	application->windowManager = windowManager;
 
@@ -542,6 +711,33 @@ int main(int argc, char *argv[])
 	application->init(resourceDir);
 	application->initGeom(resourceDir);
 
+	if (headless.isEnabled())
+	{
+		headless.setDump(dumpPrefix, dumpEvery);
+		if (!headless.init())
+		{
+			return EXIT_FAILURE;
+		}
+		// Every frame should show the real textures, not the loading placeholder
+		while (application->textureLoader.busy())
+		{
+			application->textureLoader.update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		while (!headless.done())
+		{
+			headless.beginFrame();
+			application->gFixedTime = headless.time();
+			application->render();
+			headless.endFrame();
+			glfwPollEvents();
+		}
+		headless.report();
+		application->capture.finish();
+		windowManager->shutdown();
+		return 0;
+	}
+
 	// Loop until the user closes the window.
 	while (! glfwWindowShouldClose(windowManager->getHandle()))
 	{
@@ -555,6 +751,7 @@ int main(int argc, char *argv[])
 	}
 
 	// Quit program.
+	application->capture.finish();
 	windowManager->shutdown();
 	return 0;
 }
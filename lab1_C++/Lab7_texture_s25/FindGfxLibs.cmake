@@ -40,7 +40,9 @@ function(_findGLFW3_sourcepkg target)
     option(GLFW_BUILD_TESTS "GLFW_BUILD_TESTS" OFF)
     option(GLFW_BUILD_DOCS "GLFW_BUILD_DOCS" OFF)
 
-    if(CMAKE_BUILD_TYPE MATCHES Release)
+    # Several targets may ask for GLFW; its sources are added once
+    if(TARGET glfw)
+    elseif(CMAKE_BUILD_TYPE MATCHES Release)
         add_subdirectory(${GLFW_DIR} ${GLFW_DIR}/release)
     else()
         add_subdirectory(${GLFW_DIR} ${GLFW_DIR}/debug)
@@ -59,7 +61,7 @@ function(findGLFW3 target)
     if(glfw3_FOUND)
 
         # Include paths are added automatically by the glfw3 find_package
-        target_link_libraries(${CMAKE_PROJECT_NAME} glfw)
+        target_link_libraries(${target} glfw)
 
     elseif(DEFINED ENV{GLFW_DIR})
 
@@ -0,0 +1,88 @@
+// Cost of CHECKED_GL_CALL under the GL_ERROR_CHECKS mode this binary was
+// built with; CMake builds it once per mode (GLCheckBench_POLL, _CALLBACK and
+// _NONE). Each frame, in a hidden window, issues <calls> wrapped glBindBuffer
+// calls and then the same number of bare ones, each batch finished with
+// glFinish. The difference of the two is the wrapper's overhead.
+//
+//   GLCheckBench_<MODE> [calls per frame] [frames]
+//
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "GLSL.h"
+#include "WindowManager.h"
+
+using namespace std;
+
+
+#if defined(GL_ERROR_CHECKS_CALLBACK)
+static const char *modeName = "CALLBACK";
+#elif defined(GL_ERROR_CHECKS_NONE) || defined(DISABLE_OPENGL_ERROR_CHECKS)
+static const char *modeName = "NONE";
+#else
+static const char *modeName = "POLL";
+#endif
+
+static double median(vector<double> samples)
+{
+	sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+	int calls = argc > 1 ? atoi(argv[1]) : 200000;
+	int frames = argc > 2 ? atoi(argv[2]) : 60;
+	if (calls <= 0 || frames <= 0)
+	{
+		fprintf(stderr, "usage: %s [calls per frame] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	WindowManager windowManager;
+	if (!windowManager.init(64, 64, false))
+	{
+		fprintf(stderr, "could not create an OpenGL context\n");
+		return 1;
+	}
+
+	GLuint buffers[2];
+	CHECKED_GL_CALL(glGenBuffers(2, buffers));
+
+	vector<double> wrappedMs, bareMs;
+	for (int f = 0; f < frames; f++)
+	{
+		double start = glfwGetTime();
+		for (int i = 0; i < calls; i++)
+		{
+			CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, buffers[i & 1]));
+		}
+		glFinish();
+		double middle = glfwGetTime();
+		for (int i = 0; i < calls; i++)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[i & 1]);
+		}
+		glFinish();
+		double end = glfwGetTime();
+
+		wrappedMs.push_back((middle - start) * 1000.0);
+		bareMs.push_back((end - middle) * 1000.0);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDeleteBuffers(2, buffers);
+	windowManager.shutdown();
+
+	double wrapped = median(wrappedMs), bare = median(bareMs);
+	printf("GL_ERROR_CHECKS=%s: %d calls per frame, median of %d frames\n", modeName, calls, frames);
+	printf("  CHECKED_GL_CALL  %8.3f ms/frame\n", wrapped);
+	printf("  bare call        %8.3f ms/frame\n", bare);
+	printf("  overhead         %8.1f ns/call\n", (wrapped - bare) * 1e6 / calls);
+
+	return 0;
+}
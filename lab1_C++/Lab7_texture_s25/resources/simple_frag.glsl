@@ -2,9 +2,11 @@
 
 out vec4 color;
 
-uniform vec3 MatAmb;
-uniform vec3 MatDif;
-uniform vec3 MatSpec;
+// material table (MaterialRegistry), indexed per draw
+const int MAX_MATERIALS = 16;
+struct Material { vec3 amb; float shine; vec3 dif; vec3 spec; };
+layout(std140) uniform Materials { Material materials[MAX_MATERIALS]; };
+flat in int vMat;
 
 //interpolated normal and light vector in camera space
 in vec3 fragNor;
@@ -18,13 +20,14 @@ void main()
 	vec3 normal = normalize(fragNor);
 	vec3 light = normalize(lightDir - EPos);
 
+	Material mat = materials[vMat];
 	float lambertian = max(dot(normal, light), 0.0);
 	float specular = 0.0;
 	if(lambertian > 0.0) {
 		vec3 R = reflect(-light, normal);
 		vec3 V = normalize(-EPos);
-		float specAngle = max(dor(R, V), 0.0);
-		specular = pow(specAngle, 80)
+		float specAngle = max(dot(R, V), 0.0);
+		specular = pow(specAngle, mat.shine);
 	}
-	color = vec4(MatAmb + (lambertian * MatDif) + (specular * MatSpec), 1.0);
+	color = vec4(mat.amb + (lambertian * mat.dif) + (specular * mat.spec), 1.0);
 }
@@ -1,20 +1,24 @@
 #version  330 core
 layout(location = 0) in vec4 vertPos;
 layout(location = 1) in vec3 vertNor;
-uniform mat4 P;
-uniform mat4 V;
+layout(location = 7) in int instMat; // material index (MaterialRegistry)
+layout(location = 8) in vec3 vertPosScale; // position decode (set per draw by Shape)
+layout(location = 9) in vec3 vertPosBias;
 uniform mat4 M;
-uniform vec3 lightPos;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
 
 out vec3 fragNor;
 out vec3 lightDir;
 out vec3 EPos;
+flat out int vMat;
 
 void main()
 {
-	gl_Position = P * V * M * vertPos;
+	vec4 pos = vec4(vertPosBias + vertPos.xyz * vertPosScale, 1.0);
+	gl_Position = P * V * M * pos;
 	fragNor = (V*M * vec4(vertNor, 0.0)).xyz;
-	lightDir = vec3(V*(vec4(lightPos - (M*vertPos).xyz, 0.0)));
+	lightDir = vec3(V*(vec4(lightPos.xyz - (M*pos).xyz, 0.0)));
 	//lightDir = V*(vec4(lightPos - (M*vertPos).xyz, 0.0));
-	EPos = vec3(V * M * vertPos);
+	EPos = vec3(V * M * pos);
+	vMat = instMat;
 }
@@ -2,10 +2,11 @@
 layout(location = 0) in vec3 vertPos;
 layout(location = 1) in vec3 vertNor;
 layout(location = 2) in vec2 vertTex;
-uniform mat4 P;
+layout(location = 3) in mat4 instM;
+layout(location = 8) in vec3 vertPosScale; // position decode (set per draw by Shape; identity for the ground)
+layout(location = 9) in vec3 vertPosBias;
 uniform mat4 M;
-uniform mat4 V;
-uniform vec3 lightPos;
+layout(std140) uniform Frame { mat4 P; mat4 V; vec4 lightPos; }; // shared per-frame data
 
 out vec3 fragNor;
 out vec3 lightDir;
@@ -14,12 +15,14 @@ out vec2 vTexCoord;
 
 void main() {
 
-  /* First model transforms */
-  vec3 wPos = vec3(M * vec4(vertPos.xyz, 1.0));
-  gl_Position = P * V *M * vec4(vertPos.xyz, 1.0);
+  /* First model transforms (group M then per-instance) */
+  mat4 Model = M * instM;
+  vec3 pos = vertPosBias + vertPos.xyz * vertPosScale;
+  vec3 wPos = vec3(Model * vec4(pos, 1.0));
+  gl_Position = P * V * Model * vec4(pos, 1.0);
 
-  fragNor = (V*M * vec4(vertNor, 0.0)).xyz;
-  lightDir = (V*(vec4(lightPos - wPos, 0.0))).xyz;
+  fragNor = (V*Model * vec4(vertNor, 0.0)).xyz;
+  lightDir = (V*(vec4(lightPos.xyz - wPos, 0.0))).xyz;
   EPos = (V * vec4(wPos, 1.0)).xyz;
   
   /* pass through the texture coordinates to be interpolated */
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef LAB471_FRAMECAPTURE_H_INCLUDED
+#define LAB471_FRAMECAPTURE_H_INCLUDED
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Saves rendered frames as PNG without stalling the render thread. Each
+// capture reads the bound framebuffer into one of RingSize pixel pack
+// buffers; the copy is picked up once its fence has signaled (normally
+// RingSize - 1 frames later) and encoded on worker threads. When the encoders
+// fall MaxQueued frames behind, capture() waits for them, which bounds memory.
+class FrameCapture
+{
+
+public:
+
+	static const int RingSize = 3;
+	static const size_t MaxQueued = 32;
+
+	// threads = 0 picks a count from the hardware (at most 4); they start with the first capture
+	explicit FrameCapture(int threads = 0) : threadCount(threads) {}
+	~FrameCapture();
+
+	// Render thread, after drawing the frame (reads the current GL_READ_FRAMEBUFFER)
+	void capture(const std::string &fileName, int width, int height);
+
+	// Waits for every readback and encode; needs the GL context
+	void finish();
+
+private:
+
+	struct Slot
+	{
+		GLuint pbo = 0;
+		size_t bytes = 0;
+		GLsync fence = 0;
+		std::string fileName;
+		int width = 0;
+		int height = 0;
+	};
+
+	struct Job
+	{
+		std::string fileName;
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> pixels;
+	};
+
+	// Maps a slot's buffer (waiting for its fence if wait is set) and queues the encode
+	bool collect(Slot &slot, bool wait);
+	void work();
+
+	Slot ring[RingSize];
+	int next = 0;
+
+	int threadCount;
+	std::vector<std::thread> workers;
+	std::deque<Job> jobs;
+	std::mutex queueMutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	bool quit = false;
+	int encoding = 0;
+
+	// Statistics printed by finish()
+	long captured = 0;
+	long waited = 0;
+	long throttled = 0;
+	double captureMs = 0.0;
+	double encodeMs = 0.0;
+	size_t maxQueued = 0;
+
+};
+
+#endif // LAB471_FRAMECAPTURE_H_INCLUDED
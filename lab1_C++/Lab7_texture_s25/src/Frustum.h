@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef LAB471_FRUSTUM_H_INCLUDED
+#define LAB471_FRUSTUM_H_INCLUDED
+
+#include <glm/glm.hpp>
+
+
+// The six clip planes of a camera, extracted from P*V (world space)
+class Frustum
+{
+
+public:
+
+	void extract(const glm::mat4 &PV);
+
+	// Conservative test of an object-space box placed by M: false only when
+	// the box is entirely outside one of the planes
+	bool intersects(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &M) const;
+
+private:
+
+	// (n, d) with dot(n, p) + d >= 0 on the inside
+	glm::vec4 planes[6];
+
+};
+
+#endif // LAB471_FRUSTUM_H_INCLUDED
@@ -3,7 +3,6 @@
 #ifndef LAB471_MATRIXSTACK_H_INCLUDED
 #define LAB471_MATRIXSTACK_H_INCLUDED
 
-#include <stack>
 #include <memory>
 
 #include "glm/glm.hpp"
@@ -15,16 +14,29 @@
 class MatrixStack
 {
 
-	std::stack<glm::mat4> stack;
+public:
+
+	static const int MaxMatrixSize = 100;
+
+private:
+
+	// Fixed-capacity storage so push/pop never allocate; stack[depth] is the top
+	glm::mat4 stack[MaxMatrixSize];
+	int depth = 0;
 
 public:
 
 	MatrixStack();
 
+	// Drops back to a single identity matrix so the stack can be reused every frame
+	void reset();
+
 	// Copies the current matrix and adds it to the top of the stack
+	// (reports and ignores a push beyond MaxMatrixSize matrices)
 	void pushMatrix();
 
 	// Removes the top of the stack and sets the current matrix to be the matrix that is now on top
+	// (reports and ignores a pop of the last matrix)
 	void popMatrix();
 
 	//  Sets the top matrix to be the identity
@@ -0,0 +1,265 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+
+namespace MeshOptimizer
+{
+
+CacheStats analyzeVertexCache(const vector<unsigned int> &indices, size_t vertexCount, int cacheSize)
+{
+	// FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded
+	vector<int> loadedAt(vertexCount, -cacheSize - 1);
+	int misses = 0;
+	for (unsigned int v : indices)
+	{
+		if (misses - loadedAt[v] > cacheSize)
+		{
+			loadedAt[v] = misses;
+			misses++;
+		}
+	}
+
+	CacheStats stats;
+	stats.acmr = indices.empty() ? 0.0f : misses / float(indices.size() / 3);
+	stats.atvr = vertexCount == 0 ? 0.0f : misses / float(vertexCount);
+	return stats;
+}
+
+void optimizeVertexCache(vector<unsigned int> &indices, size_t vertexCount, vector<unsigned int> &clusters, int cacheSize)
+{
+	size_t triCount = indices.size() / 3;
+	clusters.clear();
+	if (triCount == 0)
+	{
+		return;
+	}
+
+	// Vertex -> triangle adjacency, and how many unemitted triangles each vertex still has
+	vector<unsigned int> live(vertexCount, 0);
+	for (unsigned int v : indices)
+	{
+		live[v]++;
+	}
+	vector<unsigned int> offsets(vertexCount + 1, 0);
+	partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+	vector<unsigned int> adjacency(indices.size());
+	vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	vector<int> cacheTime(vertexCount, 0);
+	vector<char> emitted(triCount, 0);
+	vector<unsigned int> deadEnd;
+	vector<unsigned int> candidates;
+	vector<unsigned int> out;
+	deadEnd.reserve(indices.size());
+	out.reserve(indices.size());
+
+	int time = cacheSize + 1;
+	size_t cursor = 0;
+	long fan = 0;
+	while (fan >= 0)
+	{
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++)
+		{
+			unsigned int t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[3*t + k];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+				}
+			}
+			emitted[t] = 1;
+		}
+
+		// Next fan: the candidate that is oldest in the cache yet will still be
+		// resident after its remaining triangles are emitted
+		long next = -1;
+		int best = -1;
+		for (unsigned int v : candidates)
+		{
+			if (live[v] > 0)
+			{
+				int p = 0;
+				if (time - cacheTime[v] + 2 * (int)live[v] <= cacheSize)
+				{
+					p = time - cacheTime[v];
+				}
+				if (p > best)
+				{
+					best = p;
+					next = v;
+				}
+			}
+		}
+
+		// Dead end: back up to a recent vertex with triangles left, else scan forward
+		if (next == -1)
+		{
+			while (!deadEnd.empty() && next == -1)
+			{
+				unsigned int d = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[d] > 0)
+				{
+					next = d;
+				}
+			}
+			while (next == -1 && cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+				{
+					next = (long)cursor;
+				}
+				cursor++;
+			}
+
+			// A jump to a vertex that already left the cache is a hard boundary,
+			// so the overdraw pass can move the next run around for free
+			if (next != -1 && time - cacheTime[next] > cacheSize)
+			{
+				unsigned int start = (unsigned int)(out.size() / 3);
+				if (clusters.empty() || clusters.back() != start)
+				{
+					clusters.push_back(start);
+				}
+			}
+		}
+		fan = next;
+	}
+
+	if (clusters.empty() || clusters.front() != 0)
+	{
+		clusters.insert(clusters.begin(), 0);
+	}
+	indices.swap(out);
+}
+
+void optimizeOverdraw(vector<unsigned int> &indices, const vector<float> &positions, const vector<unsigned int> &clusters)
+{
+	size_t triCount = indices.size() / 3;
+	size_t clusterCount = clusters.size();
+	if (clusterCount < 2)
+	{
+		return;
+	}
+
+	auto vertex = [&](unsigned int v) {
+		return glm::vec3(positions[3*v + 0], positions[3*v + 1], positions[3*v + 2]);
+	};
+
+	// Area-weighted centroid and normal of every cluster (and of the whole mesh)
+	vector<glm::vec3> centroid(clusterCount, glm::vec3(0));
+	vector<glm::vec3> normal(clusterCount, glm::vec3(0));
+	vector<float> area(clusterCount, 0.0f);
+	glm::vec3 meshCentroid(0);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : triCount;
+		for (size_t t = clusters[c]; t < end; t++)
+		{
+			glm::vec3 a = vertex(indices[3*t + 0]);
+			glm::vec3 b = vertex(indices[3*t + 1]);
+			glm::vec3 d = vertex(indices[3*t + 2]);
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float w = glm::length(n);
+			centroid[c] += (a + b + d) * (w / 3.0f);
+			normal[c] += n;
+			area[c] += w;
+		}
+		meshCentroid += centroid[c];
+		meshArea += area[c];
+		if (area[c] > 0.0f)
+		{
+			centroid[c] /= area[c];
+		}
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	// Clusters far out along their own normal are likely to occlude the rest: draw them first
+	vector<float> key(clusterCount, 0.0f);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float len = glm::length(normal[c]);
+		if (len > 0.0f)
+		{
+			key[c] = glm::dot(centroid[c] - meshCentroid, normal[c] / len);
+		}
+	}
+	vector<unsigned int> order(clusterCount);
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return key[a] > key[b]; });
+
+	vector<unsigned int> out;
+	out.reserve(indices.size());
+	for (unsigned int c : order)
+	{
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : triCount;
+		out.insert(out.end(), indices.begin() + 3*clusters[c], indices.begin() + 3*end);
+	}
+	indices.swap(out);
+}
+
+vector<unsigned int> optimizeVertexFetch(vector<unsigned int> &indices, size_t vertexCount)
+{
+	const unsigned int unused = ~0u;
+	vector<unsigned int> remap(vertexCount, unused);
+	unsigned int next = 0;
+	for (unsigned int &v : indices)
+	{
+		if (remap[v] == unused)
+		{
+			remap[v] = next++;
+		}
+		v = remap[v];
+	}
+
+	// Vertices no triangle references keep a slot at the end
+	for (unsigned int &r : remap)
+	{
+		if (r == unused)
+		{
+			r = next++;
+		}
+	}
+	return remap;
+}
+
+void remapAttribute(vector<float> &attribute, int components, const vector<unsigned int> &remap)
+{
+	if (attribute.empty())
+	{
+		return;
+	}
+
+	vector<float> out(attribute.size());
+	for (size_t v = 0; v < remap.size(); v++)
+	{
+		copy_n(attribute.begin() + v * components, components, out.begin() + (size_t)remap[v] * components);
+	}
+	attribute.swap(out);
+}
+
+}
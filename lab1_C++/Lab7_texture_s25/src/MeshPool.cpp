@@ -0,0 +1,184 @@
+#include "MeshPool.h"
+#include <cstddef>
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+#include "GLSL.h"
+
+// GL 4.3 / ARB_multi_draw_indirect is not in the GL 3.3 loader, so the entry
+// point is fetched from GLFW in init()
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+using namespace std;
+
+
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+static MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+
+int MeshPool::add(const Shape &shape)
+{
+	Mesh mesh;
+	mesh.firstIndex = (GLuint)indexData.size();
+	mesh.baseVertex = (GLint)(vertexData.size() / 16);
+	shape.appendPooled(vertexData, indexData, mesh.posScale, mesh.posBias);
+	mesh.indexCount = (GLuint)indexData.size() - mesh.firstIndex;
+	meshes.push_back(mesh);
+	return (int)meshes.size() - 1;
+}
+
+void MeshPool::init()
+{
+	// baseInstance in the commands needs GL 4.2 / ARB_base_instance as well
+	bool version43 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3);
+	bool extensions = glfwExtensionSupported("GL_ARB_multi_draw_indirect") && glfwExtensionSupported("GL_ARB_base_instance");
+	multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)glfwGetProcAddress("glMultiDrawElementsIndirect");
+	indirect = multiDrawElementsIndirect && (version43 || extensions);
+
+	CHECKED_GL_CALL(glGenVertexArrays(1, &vaoID));
+	CHECKED_GL_CALL(glBindVertexArray(vaoID));
+
+	// Pooled vertices: unorm16 position, 2_10_10_10 normal, half texcoords (see Shape::appendPooled)
+	const GLsizei stride = 16;
+	CHECKED_GL_CALL(glGenBuffers(1, &vertBufID));
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vertBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.data(), GL_STATIC_DRAW));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::PosAttrib));
+	CHECKED_GL_CALL(glVertexAttribPointer(Shape::PosAttrib, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const void *)0));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::NorAttrib));
+	CHECKED_GL_CALL(glVertexAttribPointer(Shape::NorAttrib, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (const void *)8));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::TexAttrib));
+	CHECKED_GL_CALL(glVertexAttribPointer(Shape::TexAttrib, 2, GL_HALF_FLOAT, GL_FALSE, stride, (const void *)12));
+
+	CHECKED_GL_CALL(glGenBuffers(1, &eleBufID));
+	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eleBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size()*sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW));
+
+	// Everything per draw is per instance: transform, material, position decode
+	CHECKED_GL_CALL(glGenBuffers(1, &instBufID));
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+	for (int c = 0; c < 4; c++)
+	{
+		CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::InstanceAttrib + c));
+		CHECKED_GL_CALL(glVertexAttribDivisor(Shape::InstanceAttrib + c, 1));
+	}
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::InstanceAttrib + 4));
+	CHECKED_GL_CALL(glVertexAttribDivisor(Shape::InstanceAttrib + 4, 1));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::PosScaleAttrib));
+	CHECKED_GL_CALL(glVertexAttribDivisor(Shape::PosScaleAttrib, 1));
+	CHECKED_GL_CALL(glEnableVertexAttribArray(Shape::PosBiasAttrib));
+	CHECKED_GL_CALL(glVertexAttribDivisor(Shape::PosBiasAttrib, 1));
+	pointInstances(0);
+
+	// Unbind the VAO first so it keeps the element buffer binding
+	CHECKED_GL_CALL(glBindVertexArray(0));
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+
+	if (indirect)
+	{
+		CHECKED_GL_CALL(glGenBuffers(1, &cmdBufID));
+	}
+
+	cout << "mesh pool: " << meshes.size() << " meshes, " << vertexData.size() / stride << " vertices, "
+		<< indexData.size() / 3 << " triangles, " << (vertexData.size() + indexData.size()*sizeof(unsigned int)) / 1024
+		<< " KB, " << (isIndirect() ? "glMultiDrawElementsIndirect" : "one draw per command") << endl;
+}
+
+// Expects the pool's VAO and instance buffer to be bound
+void MeshPool::pointInstances(GLuint first) const
+{
+	size_t base = first * sizeof(Instance);
+	for (int c = 0; c < 4; c++)
+	{
+		CHECKED_GL_CALL(glVertexAttribPointer(Shape::InstanceAttrib + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void *)(base + c * sizeof(glm::vec4))));
+	}
+	CHECKED_GL_CALL(glVertexAttribIPointer(Shape::InstanceAttrib + 4, 1, GL_INT, sizeof(Instance), (const void *)(base + offsetof(Instance, material))));
+	CHECKED_GL_CALL(glVertexAttribPointer(Shape::PosScaleAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void *)(base + offsetof(Instance, posScale))));
+	CHECKED_GL_CALL(glVertexAttribPointer(Shape::PosBiasAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void *)(base + offsetof(Instance, posBias))));
+}
+
+void MeshPool::clear()
+{
+	instances.clear();
+	commands.clear();
+}
+
+MeshPool::Instance &MeshPool::append(int mesh)
+{
+	const Mesh &m = meshes[mesh];
+	// Instances of a command are contiguous, so a repeat of the last mesh just grows it
+	if (commands.empty() || commands.back().firstIndex != m.firstIndex)
+	{
+		commands.push_back({m.indexCount, 0, m.firstIndex, m.baseVertex, (GLuint)instances.size()});
+	}
+	commands.back().instanceCount++;
+
+	instances.push_back(Instance());
+	Instance &inst = instances.back();
+	inst.posScale = m.posScale;
+	inst.posBias = m.posBias;
+	return inst;
+}
+
+void MeshPool::submit(int mesh, const glm::mat4 &M, int material)
+{
+	Instance &inst = append(mesh);
+	inst.M = M;
+	inst.material = material;
+}
+
+void MeshPool::submit(int mesh, const vector<Shape::Instance> &list)
+{
+	for (const Shape::Instance &source : list)
+	{
+		submit(mesh, source.M, source.material);
+	}
+}
+
+void MeshPool::upload()
+{
+	if (commands.empty())
+	{
+		return;
+	}
+	// Orphan and refill; the buffers are rebuilt every frame
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+	CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, instances.size()*sizeof(Instance), instances.data(), GL_STREAM_DRAW));
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	if (indirect)
+	{
+		CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmdBufID));
+		CHECKED_GL_CALL(glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size()*sizeof(Command), commands.data(), GL_STREAM_DRAW));
+		CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+	}
+}
+
+void MeshPool::draw() const
+{
+	if (commands.empty())
+	{
+		return;
+	}
+	CHECKED_GL_CALL(glBindVertexArray(vaoID));
+	if (indirect && wantIndirect)
+	{
+		CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmdBufID));
+		CHECKED_GL_CALL(multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)0, (GLsizei)commands.size(), 0));
+		CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+		return;
+	}
+
+	// No baseInstance here, so the instanced attributes are re-pointed at each command's records
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instBufID));
+	for (const Command &cmd : commands)
+	{
+		pointInstances(cmd.baseInstance);
+		CHECKED_GL_CALL(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT,
+			(const void *)(cmd.firstIndex * sizeof(unsigned int)), cmd.instanceCount, cmd.baseVertex));
+	}
+	pointInstances(0);
+	CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
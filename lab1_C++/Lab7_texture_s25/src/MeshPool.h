@@ -0,0 +1,97 @@
+#pragma once
+#ifndef LAB471_MESHPOOL_H_INCLUDED
+#define LAB471_MESHPOOL_H_INCLUDED
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Shape.h"
+
+
+// Packs many shapes into one vertex buffer, one index buffer and one VAO so
+// a whole batch of them draws with a single glMultiDrawElementsIndirect.
+// Everything that varies per draw - the model matrix, material and position
+// decode - travels in a per-instance buffer at the attribute locations Shape
+// uses, and each indirect command's baseInstance selects its records, so the
+// shaders need no changes. Without GL 4.3 the same buffers are drawn one
+// command at a time (GL 3.3 has no way to vary attributes inside a
+// glMultiDrawElements), still without rebinding anything in between.
+class MeshPool
+{
+
+public:
+
+	// Appends a shape (measured, and optimized if at all) and returns its mesh index; call before init()
+	int add(const Shape &shape);
+
+	// Uploads the shared buffers and records the VAO; picks the indirect path when available
+	void init();
+
+	// Uses the one-command-at-a-time path even when indirect draws are available (for comparison)
+	void setIndirect(bool enable) { wantIndirect = enable; }
+	bool isIndirect() const { return indirect && wantIndirect; }
+
+	// Per frame: collect the draws, upload them once, then draw them in any number of passes.
+	// Consecutive draws of the same mesh merge into one command.
+	void clear();
+	void submit(int mesh, const glm::mat4 &M, int material = 0);
+	void submit(int mesh, const std::vector<Shape::Instance> &instances);
+	void upload();
+	// Expects the program to be bound; leaves the pool's VAO bound
+	void draw() const;
+
+	int getCommandCount() const { return (int)commands.size(); }
+	int getInstanceCount() const { return (int)instances.size(); }
+
+private:
+
+	struct Mesh
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+		glm::vec3 posScale;
+		glm::vec3 posBias;
+	};
+
+	// Laid out for the instanced attributes 3..9
+	struct Instance
+	{
+		glm::mat4 M;
+		int material;
+		glm::vec3 posScale;
+		glm::vec3 posBias;
+	};
+
+	// DrawElementsIndirectCommand
+	struct Command
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// Points the instanced attributes at the record with this index
+	void pointInstances(GLuint first) const;
+	Instance &append(int mesh);
+
+	std::vector<unsigned char> vertexData;
+	std::vector<unsigned int> indexData;
+	std::vector<Mesh> meshes;
+	std::vector<Instance> instances;
+	std::vector<Command> commands;
+
+	GLuint vaoID = 0;
+	GLuint vertBufID = 0;
+	GLuint eleBufID = 0;
+	GLuint instBufID = 0;
+	GLuint cmdBufID = 0;
+	bool wantIndirect = true;
+	bool indirect = false;
+
+};
+
+#endif // LAB471_MESHPOOL_H_INCLUDED
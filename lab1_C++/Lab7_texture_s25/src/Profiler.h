@@ -0,0 +1,85 @@
+#pragma once
+#ifndef LAB471_PROFILER_H_INCLUDED
+#define LAB471_PROFILER_H_INCLUDED
+
+#include <glad/glad.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+// Per-pass CPU and GPU timings. Each pass gets a ring of GL_TIME_ELAPSED
+// queries, one per frame in flight, which are read back Latency frames
+// later without stalling. Averages over every reportInterval frames go to
+// stdout, every sample can go to a CSV file, and drawOverlay() shows the
+// averages as bars (GPU thick, CPU thin, 1/60 s = full width) whose colors
+// are named in the stdout report.
+class Profiler
+{
+
+public:
+
+	// Frames between issuing a query and reading it back
+	static const int Latency = 4;
+
+	// Nothing is measured (and no queries are created) until enabled
+	void setEnabled(bool e) { enabled = e; }
+	bool isEnabled() const { return enabled; }
+	// Enables the profiler too; drawOverlay() does nothing while this is off
+	void setOverlay(bool o) { overlay = o; enabled = enabled || o; }
+	bool hasOverlay() const { return overlay; }
+	void setReportInterval(int frames) { reportInterval = frames > 0 ? frames : 1; }
+	bool openCsv(const std::string &fileName);
+
+	// Brackets a whole frame: collects finished queries and prints averages
+	void beginFrame();
+	void endFrame();
+
+	// Brackets one pass; passes cannot nest (GL allows one GL_TIME_ELAPSED query at a time)
+	void begin(const char *name);
+	void end();
+
+	void drawOverlay(int width, int height) const;
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Sample
+	{
+		GLuint query = 0;
+		bool pending = false;
+		long frame = 0;
+		double cpuMs = 0.0;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		Sample ring[Latency];
+		double cpuSum = 0.0, gpuSum = 0.0;
+		int cpuCount = 0, gpuCount = 0;
+		double cpuAvg = 0.0, gpuAvg = 0.0;
+	};
+
+	bool collect(Pass &pass, Sample &sample);
+	void report();
+
+	bool enabled = false;
+	bool overlay = false;
+	int reportInterval = 60;
+	std::ofstream csv;
+
+	std::vector<Pass> passes;
+	int active = -1;
+	Clock::time_point passStart;
+	Clock::time_point frameStart;
+	long frame = 0;
+	double frameSum = 0.0;
+	int frameCount = 0;
+	int dropped = 0;
+
+};
+
+#endif // LAB471_PROFILER_H_INCLUDED
@@ -5,6 +5,7 @@
 #include <fstream>
 
 #include "GLSL.h"
+#include "ProgramCache.h"
 
 
 std::string readFileAsString(const std::string &fileName)
@@ -38,13 +39,23 @@ bool Program::init()
 {
 	GLint rc;
 
+	// Read shader sources
+	std::string vShaderString = readFileAsString(vShaderName);
+	std::string fShaderString = readFileAsString(fShaderName);
+
+	// Reuse the linked binary from an earlier run when sources and driver are unchanged
+	std::string cachePath = ProgramCache::path(vShaderName, fShaderName);
+	uint64_t cacheKey = ProgramCache::hash({vShaderString, fShaderString});
+	pid = ProgramCache::load(cachePath, cacheKey);
+	if (pid != 0)
+	{
+		return true;
+	}
+
 	// Create shader handles
 	GLuint VS = glCreateShader(GL_VERTEX_SHADER);
 	GLuint FS = glCreateShader(GL_FRAGMENT_SHADER);
 
-	// Read shader sources
-	std::string vShaderString = readFileAsString(vShaderName);
-	std::string fShaderString = readFileAsString(fShaderName);
 	const char *vshader = vShaderString.c_str();
 	const char *fshader = fShaderString.c_str();
 	CHECKED_GL_CALL(glShaderSource(VS, 1, &vshader, NULL));
@@ -80,6 +91,12 @@ bool Program::init()
 	pid = glCreateProgram();
 	CHECKED_GL_CALL(glAttachShader(pid, VS));
 	CHECKED_GL_CALL(glAttachShader(pid, FS));
+	// Pin the vertex inputs to the locations Shape records in its VAO
+	// (explicit layout qualifiers in the shader take precedence)
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 0, "vertPos"));
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 1, "vertNor"));
+	CHECKED_GL_CALL(glBindAttribLocation(pid, 2, "vertTex"));
+	ProgramCache::prepare(pid);
 	CHECKED_GL_CALL(glLinkProgram(pid));
 	CHECKED_GL_CALL(glGetProgramiv(pid, GL_LINK_STATUS, &rc));
 	if (!rc)
@@ -92,6 +109,7 @@ bool Program::init()
 		return false;
 	}
 
+	ProgramCache::store(cachePath, cacheKey, pid);
 	return true;
 }
 
@@ -110,9 +128,25 @@ void Program::addAttribute(const std::string &name)
 	attributes[name] = GLSL::getAttribLocation(pid, name.c_str(), isVerbose());
 }
 
-void Program::addUniform(const std::string &name)
+GLint Program::addUniform(const std::string &name)
 {
-	uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
+	GLint location = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
+	uniforms[name] = location;
+	return location;
+}
+
+void Program::bindUniformBlock(const std::string &name, GLuint binding) const
+{
+	GLuint index = glGetUniformBlockIndex(pid, name.c_str());
+	if (index == GL_INVALID_INDEX)
+	{
+		if (isVerbose())
+		{
+			std::cout << name << " is not a uniform block" << std::endl;
+		}
+		return;
+	}
+	CHECKED_GL_CALL(glUniformBlockBinding(pid, index, binding));
 }
 
 GLint Program::getAttribute(const std::string &name) const
@@ -9,6 +9,8 @@
 
 #include <glad/glad.h>
 
+#include "Uniform.h"
+
 
 std::string readFileAsString(const std::string &fileName);
 
@@ -26,10 +28,17 @@ public:
 	virtual void unbind();
 
 	void addAttribute(const std::string &name);
-	void addUniform(const std::string &name);
+	GLint addUniform(const std::string &name);
 	GLint getAttribute(const std::string &name) const;
 	GLint getUniform(const std::string &name) const;
 
+	// Resolve a uniform once at init and keep the typed handle for drawing
+	template <typename T>
+	Uniform<T> uniform(const std::string &name) { return Uniform<T>(addUniform(name)); }
+
+	// Attach a named uniform block to a UniformBuffer binding point
+	void bindUniformBlock(const std::string &name, GLuint binding) const;
+
 protected:
 
 	std::string vShaderName;
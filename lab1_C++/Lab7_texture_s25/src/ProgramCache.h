@@ -0,0 +1,38 @@
+#pragma once
+#ifndef LAB471_PROGRAMCACHE_H_INCLUDED
+#define LAB471_PROGRAMCACHE_H_INCLUDED
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Linked program binaries (glGetProgramBinary) stored next to the shaders.
+// A file is only used when both the hash of the sources and the driver
+// (GL_VENDOR, GL_RENDERER, GL_VERSION) match; anything else is a miss and
+// the caller compiles as usual, then stores the fresh binary.
+namespace ProgramCache
+{
+
+	// False when the context has no program binary formats (GL < 4.1 without ARB_get_program_binary)
+	bool supported();
+
+	// Cache file for a vertex/fragment(/geometry) shader set
+	std::string path(const std::string &vShaderName, const std::string &fShaderName, const std::string &gShaderName = "");
+
+	// Key for the shader sources (and anything else baked in at link time)
+	uint64_t hash(const std::vector<std::string> &sources);
+
+	// Returns a linked program, or 0 when there is no usable binary for key
+	GLuint load(const std::string &path, uint64_t key);
+
+	// Call before glLinkProgram so the driver keeps the binary around
+	void prepare(GLuint pid);
+
+	// Writes the linked program's binary; failures are silent (the cache is optional)
+	void store(const std::string &path, uint64_t key, GLuint pid);
+
+}
+
+#endif // LAB471_PROGRAMCACHE_H_INCLUDED
@@ -0,0 +1,201 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GLSL.h"
+#include "Program.h"
+#include "Profiler.h"
+#include "Shape.h"
+#include "Texture.h"
+
+using namespace std;
+
+
+bool RenderQueue::Stats::operator==(const Stats &o) const
+{
+	return draws == o.draws && passes == o.passes && programBinds == o.programBinds &&
+		textureBinds == o.textureBinds && materialChanges == o.materialChanges && redundant == o.redundant;
+}
+
+int RenderQueue::addPass(const string &name, function<void()> begin, function<void()> end)
+{
+	Pass pass;
+	pass.name = name;
+	pass.begin = begin;
+	pass.end = end;
+	passes.push_back(pass);
+	return (int)passes.size() - 1;
+}
+
+void RenderQueue::begin(const glm::mat4 &v)
+{
+	view = v;
+	draws.clear();
+}
+
+void RenderQueue::submit(const Draw &draw)
+{
+	if (draw.pass < 0 || draw.pass >= (int)passes.size() || !draw.program || !draw.call)
+	{
+		cerr << "RenderQueue: draw without a valid pass, program or call" << endl;
+		return;
+	}
+	draws.push_back(draw);
+}
+
+uint64_t RenderQueue::slot(vector<const void *> &ids, const void *id)
+{
+	if (!id)
+	{
+		return 0;
+	}
+	size_t i = find(ids.begin(), ids.end(), id) - ids.begin();
+	if (i == ids.size())
+	{
+		ids.push_back(id);
+	}
+	// Past 255 distinct ids the key only sorts coarser; state is still compared exactly
+	return std::min<uint64_t>(i + 1, 255);
+}
+
+uint64_t RenderQueue::makeKey(const Draw &draw)
+{
+	float depth = draw.depth;
+	if (depth < 0.0f)
+	{
+		depth = -(view * draw.model[3]).z;
+	}
+	// Non-negative floats order the same as their bit patterns
+	depth = std::max(depth, 0.0f);
+	uint32_t depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	uint64_t material = (uint64_t)std::min(draw.material + 1, 255);
+	return (uint64_t)std::min(draw.pass, 255) << 56 |
+		slot(programIds, draw.program) << 48 |
+		material << 40 |
+		slot(textureIds, draw.texture) << 32 |
+		depthBits;
+}
+
+void RenderQueue::execute(Profiler *profiler)
+{
+	order.clear();
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		order.push_back({makeKey(draws[i]), (uint32_t)i});
+	}
+	sort(order.begin(), order.end());
+
+	stats = Stats();
+	stats.draws = (int)draws.size();
+
+	int pass = -1;
+	Program *program = nullptr;
+	Texture *texture = nullptr;
+	// The material attribute is context state; -1 until this frame sets it
+	int material = -1;
+	for (const Entry &entry : order)
+	{
+		const Draw &draw = draws[entry.index];
+		if (draw.pass != pass)
+		{
+			if (pass >= 0)
+			{
+				if (passes[pass].end)
+				{
+					passes[pass].end();
+				}
+				if (profiler)
+				{
+					profiler->end();
+				}
+			}
+			pass = draw.pass;
+			stats.passes++;
+			if (profiler)
+			{
+				profiler->begin(passes[pass].name.c_str());
+			}
+			if (passes[pass].begin)
+			{
+				passes[pass].begin();
+			}
+		}
+
+		if (draw.program != program)
+		{
+			draw.program->bind();
+			program = draw.program;
+			// The sampler uniform belongs to the program, so the next texture binds again
+			texture = nullptr;
+			stats.programBinds++;
+		}
+		else
+		{
+			stats.redundant++;
+		}
+
+		if (draw.texture)
+		{
+			if (draw.texture != texture)
+			{
+				draw.texture->bind(draw.sampler.getLocation());
+				texture = draw.texture;
+				stats.textureBinds++;
+			}
+			else
+			{
+				stats.redundant++;
+			}
+		}
+
+		if (draw.material >= 0)
+		{
+			if (draw.material != material)
+			{
+				CHECKED_GL_CALL(glVertexAttribI4i(Shape::InstanceAttrib + 4, draw.material, 0, 0, 0));
+				material = draw.material;
+				stats.materialChanges++;
+			}
+			else
+			{
+				stats.redundant++;
+			}
+		}
+
+		draw.modelUniform.set(draw.model);
+		(*draw.call)();
+	}
+
+	if (pass >= 0)
+	{
+		if (passes[pass].end)
+		{
+			passes[pass].end();
+		}
+		if (profiler)
+		{
+			profiler->end();
+		}
+	}
+	if (program)
+	{
+		program->unbind();
+	}
+	draws.clear();
+}
+
+void RenderQueue::reportChanges()
+{
+	if (hasReported && stats == reported)
+	{
+		return;
+	}
+	hasReported = true;
+	reported = stats;
+	cout << "render queue: " << stats.draws << " draws in " << stats.passes << " passes, "
+		<< stats.programBinds << " program binds, " << stats.textureBinds << " texture binds, "
+		<< stats.materialChanges << " material changes (" << stats.redundant << " redundant skipped)" << endl;
+}
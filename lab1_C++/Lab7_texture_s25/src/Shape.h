@@ -10,7 +10,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <tiny_obj_loader/tiny_obj_loader.h>
 
-class Program;
+class Frustum;
 
 
 class Shape
@@ -18,25 +18,88 @@ class Shape
 
 public:
 
+	// Per-instance data streamed to the instanced attributes (see InstanceAttrib)
+	struct Instance
+	{
+		glm::mat4 M;
+		int material;
+	};
+
+	// Fixed attribute locations recorded in the VAO; shaders must match them
+	static const unsigned int PosAttrib = 0;
+	static const unsigned int NorAttrib = 1;
+	static const unsigned int TexAttrib = 2;
+
+	// First attribute location of the per-instance model matrix (3..6);
+	// the material index follows at InstanceAttrib + 4
+	static const unsigned int InstanceAttrib = 3;
+
+	// Generic attributes set per draw that decode compressed positions:
+	// pos = vertPosBias + vertPos * vertPosScale (identity for float data)
+	static const unsigned int PosScaleAttrib = 8;
+	static const unsigned int PosBiasAttrib = 9;
+
 	void createShape(tinyobj::shape_t & shape);
-	void init();
+	// Takes over the shape's buffers instead of copying them
+	void createShape(tinyobj::shape_t && shape);
+	// Reorders triangles and vertices for the GPU vertex caches and prints
+	// the ACMR/ATVR gain; call between createShape() and init()
+	void optimize();
+	// Uploads one interleaved vertex buffer. Compressed stores positions as
+	// unorm16 within measure()'s bounds, normals as 2_10_10_10 and texcoords
+	// as half floats; indices are 16-bit whenever the vertex count allows.
+	void init(bool compressed = true);
 	void measure();
-	void draw(const std::shared_ptr<Program> prog) const;
+	void draw() const;
+
+	// Appends the geometry in MeshPool's shared layout (compressed, 16 bytes
+	// per vertex, zero normal/texcoords when missing) and returns its position
+	// decode; indices stay relative to the shape's first vertex. Needs measure().
+	void appendPooled(std::vector<unsigned char> &vertices, std::vector<unsigned int> &indices,
+		glm::vec3 &scale, glm::vec3 &bias) const;
+
+	// Uploads the per-instance transforms/materials used by drawInstanced()
+	void setInstances(const std::vector<Instance> &instances);
+	void drawInstanced() const;
+	int getInstanceCount() const { return instanceCount; }
+
+	// Re-uploads only the instances whose bounds (min/max placed by their M)
+	// touch the frustum; drawInstanced() then draws that subset. Returns its size.
+	int cullInstances(const Frustum &frustum);
+	const std::vector<Instance> &getVisibleInstances() const { return visibleInstances; }
+
+	// Normal visualization: a line buffer built once from every stride-th
+	// vertex, each segment `length` long in object space
+	void initNormalLines(int stride, float length);
+	void drawNormalLines() const;
+	void drawNormalLinesInstanced() const;
 
 	glm::vec3 min = glm::vec3(0);
 	glm::vec3 max = glm::vec3(0);
 
 private:
 
+	void drawElements(int instances) const;
+	void drawLines(int instances) const;
+	void recordInstanceLayout() const;
+
 	std::vector<unsigned int> eleBuf;
 	std::vector<float> posBuf;
 	std::vector<float> norBuf;
 	std::vector<float> texBuf;
 	unsigned int eleBufID = 0;
-	unsigned int posBufID = 0;
-	unsigned int norBufID = 0;
-	unsigned int texBufID = 0;
+	unsigned int eleType = 0;
+	unsigned int vertBufID = 0;
 	unsigned int vaoID = 0;
+	glm::vec3 posScale = glm::vec3(1);
+	glm::vec3 posBias = glm::vec3(0);
+	unsigned int instBufID = 0;
+	int instanceCount = 0;
+	std::vector<Instance> allInstances;
+	std::vector<Instance> visibleInstances;
+	unsigned int lineVaoID = 0;
+	unsigned int lineBufID = 0;
+	int lineVertCount = 0;
 
 };
 
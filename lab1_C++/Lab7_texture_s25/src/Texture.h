@@ -5,13 +5,22 @@
 #include <glad/glad.h>
 #include <string>
 
+namespace TextureCache { class Image; }
+
 class Texture
 {
 public:
 	Texture();
 	virtual ~Texture();
 	void setFilename(const std::string &f) { filename = f; }
+	const std::string &getFilename() const { return filename; }
 	void init();
+	// 1x1 stand-in so the texture can be bound while its image loads (see TextureLoader)
+	void initPlaceholder(unsigned char r, unsigned char g, unsigned char b);
+	// Replaces the image with every level of a cooked mip chain. pixels points at
+	// image.pixels(), or is null when a GL_PIXEL_UNPACK_BUFFER holds a copy at offset 0.
+	void uploadLevels(const TextureCache::Image &image, const unsigned char *pixels);
+	bool isReady() const { return ready; }
 	void setUnit(GLint u) { unit = u; }
 	GLint getUnit() const { return unit; }
 	void bind(GLint handle);
@@ -24,6 +33,7 @@ private:
 	int height;
 	GLuint tid;
 	GLint unit;
+	bool ready;
 	
 };
 
@@ -0,0 +1,398 @@
+#include "TextureCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "stb_image.h"
+
+using namespace std;
+
+
+namespace TextureCache
+{
+
+// Bump whenever the cooked layout or filtering changes so old files are re-cooked
+static const uint32_t CookVersion = 1;
+
+struct FileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t sourceWidth;
+	uint32_t sourceHeight;
+	uint32_t components;
+	uint32_t levelCount;
+};
+
+struct FileLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;
+	uint64_t size;
+};
+
+static uint64_t hashBytes(const vector<unsigned char> &bytes)
+{
+	uint64_t h = 1469598103934665603ull; // FNV-1a
+	for (unsigned char b : bytes)
+	{
+		h = (h ^ b) * 1099511628211ull;
+	}
+	return h;
+}
+
+// Unique to this process and thread, so concurrent cooks (in this or another
+// run of the app) never write into the same temp file
+static string tempPath(const string &path)
+{
+#ifdef _WIN32
+	unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+	unsigned long pid = (unsigned long)getpid();
+#endif
+	return path + ".tmp" + to_string(pid) + "_" + to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+static bool readFile(const string &path, vector<unsigned char> &bytes)
+{
+	ifstream in(path, ios::binary | ios::ate);
+	if (!in)
+	{
+		return false;
+	}
+	bytes.resize((size_t)in.tellg());
+	in.seekg(0);
+	return (bool)in.read((char *)bytes.data(), bytes.size());
+}
+
+static int nextPowerOfTwo(int n)
+{
+	int p = 1;
+	while (p < n)
+	{
+		p <<= 1;
+	}
+	return p;
+}
+
+// Bilinear resample with pixel centers aligned between the two grids
+static void resample(const unsigned char *src, int w, int h, int c, unsigned char *dst, int W, int H)
+{
+	for (int y = 0; y < H; y++)
+	{
+		float fy = std::max(0.0f, (y + 0.5f) * h / H - 0.5f);
+		int y0 = std::min((int)fy, h - 1);
+		int y1 = std::min(y0 + 1, h - 1);
+		float ty = fy - y0;
+		for (int x = 0; x < W; x++)
+		{
+			float fx = std::max(0.0f, (x + 0.5f) * w / W - 0.5f);
+			int x0 = std::min((int)fx, w - 1);
+			int x1 = std::min(x0 + 1, w - 1);
+			float tx = fx - x0;
+			for (int k = 0; k < c; k++)
+			{
+				float a = src[(y0*w + x0)*c + k] * (1 - tx) + src[(y0*w + x1)*c + k] * tx;
+				float b = src[(y1*w + x0)*c + k] * (1 - tx) + src[(y1*w + x1)*c + k] * tx;
+				dst[(y*W + x)*c + k] = (unsigned char)std::lround(a * (1 - ty) + b * ty);
+			}
+		}
+	}
+}
+
+// 2x2 box filter; a side that is already 1 texel stays 1
+static void downsample(const unsigned char *src, int w, int h, int c, unsigned char *dst)
+{
+	int W = std::max(1, w / 2);
+	int H = std::max(1, h / 2);
+	for (int y = 0; y < H; y++)
+	{
+		int y0 = std::min(2*y, h - 1);
+		int y1 = std::min(2*y + 1, h - 1);
+		for (int x = 0; x < W; x++)
+		{
+			int x0 = std::min(2*x, w - 1);
+			int x1 = std::min(2*x + 1, w - 1);
+			for (int k = 0; k < c; k++)
+			{
+				int sum = src[(y0*w + x0)*c + k] + src[(y0*w + x1)*c + k] + src[(y1*w + x0)*c + k] + src[(y1*w + x1)*c + k];
+				dst[(y*W + x)*c + k] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// Decodes, flips to GL's bottom-up rows, resamples to powers of two and appends every mip level
+static bool cook(const vector<unsigned char> &source, uint64_t hash, vector<unsigned char> &file)
+{
+	int w, h, c;
+	if (!stbi_info_from_memory(source.data(), (int)source.size(), &w, &h, &c))
+	{
+		return false;
+	}
+	int components = (c == 2 || c == 4) ? 4 : 3;
+	unsigned char *decoded = stbi_load_from_memory(source.data(), (int)source.size(), &w, &h, &c, components);
+	if (!decoded)
+	{
+		return false;
+	}
+
+	size_t row = (size_t)w * components;
+	vector<unsigned char> base(decoded, decoded + row * h);
+	stbi_image_free(decoded);
+	for (int y = 0; y < h / 2; y++)
+	{
+		std::swap_ranges(base.begin() + y*row, base.begin() + (y + 1)*row, base.begin() + (h - 1 - y)*row);
+	}
+
+	int W = nextPowerOfTwo(w);
+	int H = nextPowerOfTwo(h);
+	if (W != w || H != h)
+	{
+		vector<unsigned char> scaled((size_t)W * H * components);
+		resample(base.data(), w, h, components, scaled.data(), W, H);
+		base.swap(scaled);
+	}
+
+	vector<FileLevel> levels;
+	vector<unsigned char> pixels(base);
+	levels.push_back({(uint32_t)W, (uint32_t)H, 0, base.size()});
+	while (W > 1 || H > 1)
+	{
+		const FileLevel &prev = levels.back();
+		W = std::max(1, W / 2);
+		H = std::max(1, H / 2);
+		FileLevel level = {(uint32_t)W, (uint32_t)H, pixels.size(), (uint64_t)W * H * components};
+		pixels.resize(pixels.size() + level.size);
+		downsample(&pixels[prev.offset], prev.width, prev.height, components, &pixels[level.offset]);
+		levels.push_back(level);
+	}
+
+	FileHeader header = {{'M', 'I', 'P', '1'}, CookVersion, hash, (uint32_t)w, (uint32_t)h, (uint32_t)components, (uint32_t)levels.size()};
+	size_t tableSize = levels.size() * sizeof(FileLevel);
+	file.resize(sizeof(header) + tableSize + pixels.size());
+	memcpy(&file[0], &header, sizeof(header));
+	memcpy(&file[sizeof(header)], levels.data(), tableSize);
+	memcpy(&file[sizeof(header) + tableSize], pixels.data(), pixels.size());
+	return true;
+}
+
+// Checks a cooked file against the source hash and fills in image's level table
+static bool parse(const unsigned char *bytes, size_t size, uint64_t hash, Image &image, size_t &dataOffset)
+{
+	FileHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, bytes, sizeof(header));
+	if (memcmp(header.magic, "MIP1", 4) != 0 || header.version != CookVersion || header.sourceHash != hash || header.levelCount == 0)
+	{
+		return false;
+	}
+
+	dataOffset = sizeof(header) + header.levelCount * sizeof(FileLevel);
+	if (size < dataOffset)
+	{
+		return false;
+	}
+	image.levels.clear();
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		FileLevel level;
+		memcpy(&level, bytes + sizeof(header) + i * sizeof(FileLevel), sizeof(level));
+		if (dataOffset + level.offset + level.size > size)
+		{
+			return false;
+		}
+		image.levels.push_back({(int)level.width, (int)level.height, (size_t)level.offset, (size_t)level.size});
+	}
+	image.components = (int)header.components;
+	image.sourceWidth = (int)header.sourceWidth;
+	image.sourceHeight = (int)header.sourceHeight;
+	return true;
+}
+
+static void *mapFile(const string &path, size_t &size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = (size_t)fileSize.QuadPart;
+	HANDLE mapping = size ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	// The view keeps the file mapped after both handles are closed
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+	return view;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+	struct stat st;
+	void *view = nullptr;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		size = (size_t)st.st_size;
+		view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED)
+		{
+			view = nullptr;
+		}
+	}
+	close(fd);
+	return view;
+#endif
+}
+
+static void unmapFile(void *view, size_t size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(view);
+#else
+	munmap(view, size);
+#endif
+}
+
+Image::~Image()
+{
+	release();
+}
+
+Image::Image(Image &&other)
+{
+	*this = std::move(other);
+}
+
+Image &Image::operator=(Image &&other)
+{
+	if (this != &other)
+	{
+		release();
+		components = other.components;
+		levels = std::move(other.levels);
+		sourceWidth = other.sourceWidth;
+		sourceHeight = other.sourceHeight;
+		cooked = other.cooked;
+		data = other.data;
+		dataSize = other.dataSize;
+		owned = std::move(other.owned);
+		mapping = other.mapping;
+		mappingSize = other.mappingSize;
+		other.data = nullptr;
+		other.dataSize = 0;
+		other.mapping = nullptr;
+		other.mappingSize = 0;
+	}
+	return *this;
+}
+
+void Image::release()
+{
+	if (mapping)
+	{
+		unmapFile(mapping, mappingSize);
+	}
+	mapping = nullptr;
+	mappingSize = 0;
+	owned.clear();
+	data = nullptr;
+	dataSize = 0;
+}
+
+bool load(const string &source, Image &image)
+{
+	image.release();
+	vector<unsigned char> bytes;
+	if (!readFile(source, bytes))
+	{
+		return false;
+	}
+	uint64_t hash = hashBytes(bytes);
+	string cachePath = source + ".mip";
+	size_t dataOffset = 0;
+
+	// Cached: map the file and point straight into it
+	image.mapping = mapFile(cachePath, image.mappingSize);
+	if (image.mapping && parse((const unsigned char *)image.mapping, image.mappingSize, hash, image, dataOffset))
+	{
+		image.data = (const unsigned char *)image.mapping + dataOffset;
+		image.dataSize = image.mappingSize - dataOffset;
+		image.cooked = false;
+		return true;
+	}
+	image.release();
+
+	// Missing or stale: cook, then publish atomically so concurrent loaders never see half a file
+	vector<unsigned char> file;
+	if (!cook(bytes, hash, file))
+	{
+		return false;
+	}
+	image.cooked = true;
+	string tmpPath = tempPath(cachePath);
+	bool written = false;
+	{
+		ofstream out(tmpPath, ios::binary | ios::trunc);
+		written = out && out.write((const char *)file.data(), file.size());
+	}
+	if (written)
+	{
+#ifdef _WIN32
+		std::remove(cachePath.c_str()); // rename does not replace on Windows
+#endif
+		written = std::rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+	}
+	if (!written)
+	{
+		std::remove(tmpPath.c_str());
+	}
+
+	image.mapping = written ? mapFile(cachePath, image.mappingSize) : nullptr;
+	if (image.mapping && parse((const unsigned char *)image.mapping, image.mappingSize, hash, image, dataOffset))
+	{
+		image.data = (const unsigned char *)image.mapping + dataOffset;
+		image.dataSize = image.mappingSize - dataOffset;
+		return true;
+	}
+	if (image.mapping)
+	{
+		unmapFile(image.mapping, image.mappingSize);
+		image.mapping = nullptr;
+	}
+
+	// Read-only resources: keep the cooked bytes in memory instead
+	parse(file.data(), file.size(), hash, image, dataOffset);
+	image.owned.swap(file);
+	image.data = image.owned.data() + dataOffset;
+	image.dataSize = image.owned.size() - dataOffset;
+	return true;
+}
+
+}
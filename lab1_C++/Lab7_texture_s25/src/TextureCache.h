@@ -0,0 +1,64 @@
+#pragma once
+#ifndef LAB471_TEXTURECACHE_H_INCLUDED
+#define LAB471_TEXTURECACHE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Cooked textures: a source image decoded once, resampled to power-of-two
+// sizes and stored with its full mip chain in "<source>.mip". The file is
+// keyed by a hash of the source bytes and memory-mapped on later runs.
+namespace TextureCache
+{
+
+	struct Level
+	{
+		int width;
+		int height;
+		size_t offset; // from the start of Image::pixels()
+		size_t size;
+	};
+
+	// Every mip level, tightly packed (level 0 first), rows bottom-up for GL
+	class Image
+	{
+	public:
+		Image() {}
+		~Image();
+		Image(Image &&other);
+		Image &operator=(Image &&other);
+		Image(const Image &) = delete;
+		Image &operator=(const Image &) = delete;
+
+		const unsigned char *pixels() const { return data; }
+		size_t size() const { return dataSize; }
+		int width() const { return levels.empty() ? 0 : levels[0].width; }
+		int height() const { return levels.empty() ? 0 : levels[0].height; }
+
+		int components = 0;
+		std::vector<Level> levels;
+		int sourceWidth = 0;
+		int sourceHeight = 0;
+		bool cooked = false; // true when this run had to decode the source
+
+	private:
+		friend bool load(const std::string &source, Image &image);
+		void release();
+
+		const unsigned char *data = nullptr;
+		size_t dataSize = 0;
+		std::vector<unsigned char> owned; // used when the cache file cannot be written
+		void *mapping = nullptr;
+		size_t mappingSize = 0;
+	};
+
+	// Maps the cooked file for source, cooking it first when missing or stale.
+	// Thread safe; returns false when the source cannot be read or decoded.
+	bool load(const std::string &source, Image &image);
+
+}
+
+#endif // LAB471_TEXTURECACHE_H_INCLUDED
@@ -0,0 +1,137 @@
+#include "TextureLoader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GLSL.h"
+#include "Texture.h"
+
+using namespace std;
+
+
+TextureLoader::TextureLoader(int threads)
+{
+	if (threads <= 0)
+	{
+		threads = (int)std::min(4u, std::max(1u, thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < threads; i++)
+	{
+		workers.emplace_back(&TextureLoader::work, this);
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (thread &t : workers)
+	{
+		t.join();
+	}
+	// The pixel buffer belongs to the GL context, which may already be gone here
+}
+
+void TextureLoader::load(const shared_ptr<Texture> &texture)
+{
+	texture->initPlaceholder(128, 128, 128);
+
+	Job job;
+	job.texture = texture;
+	job.requested = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		pending.push_back(std::move(job));
+		outstanding++;
+	}
+	wake.notify_one();
+}
+
+void TextureLoader::work()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			wake.wait(lock, [this] { return quit || !pending.empty(); });
+			if (quit)
+			{
+				return;
+			}
+			job = std::move(pending.front());
+			pending.pop_front();
+		}
+
+		Clock::time_point start = Clock::now();
+		job.loaded = TextureCache::load(job.texture->getFilename(), job.image);
+		job.loadMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		decoded.push_back(std::move(job));
+	}
+}
+
+void TextureLoader::update()
+{
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (decoded.empty())
+		{
+			return;
+		}
+		job = std::move(decoded.front());
+		decoded.pop_front();
+		outstanding--;
+	}
+
+	const string &filename = job.texture->getFilename();
+	if (!job.loaded)
+	{
+		cerr << filename << " not found or not an image (keeping the placeholder)" << endl;
+		return;
+	}
+
+	// The whole mip chain goes through the buffer in one copy; each level is an offset into it
+	Clock::time_point start = Clock::now();
+	size_t bytes = job.image.size();
+	if (pbo == 0)
+	{
+		CHECKED_GL_CALL(glGenBuffers(1, &pbo));
+	}
+
+	// Orphan the previous contents so the copy never waits on an upload in flight
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo));
+	CHECKED_GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW));
+	void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (dst)
+	{
+		memcpy(dst, job.image.pixels(), bytes);
+		CHECKED_GL_CALL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		job.texture->uploadLevels(job.image, nullptr);
+	}
+	else
+	{
+		cerr << filename << ": could not map the pixel buffer (keeping the placeholder)" << endl;
+	}
+	CHECKED_GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+	double uploadMs = chrono::duration<double, milli>(Clock::now() - start).count();
+	double readyMs = chrono::duration<double, milli>(Clock::now() - job.requested).count();
+	const TextureCache::Image &image = job.image;
+	cout << "texture " << filename << " " << image.sourceWidth << "x" << image.sourceHeight << " -> "
+		<< image.width() << "x" << image.height() << ", " << image.levels.size() << " levels: "
+		<< (image.cooked ? "cooked in " : "mapped in ") << job.loadMs << " ms, upload " << uploadMs
+		<< " ms, ready " << readyMs << " ms after request" << endl;
+}
+
+bool TextureLoader::busy() const
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return outstanding > 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#ifndef LAB471_UNIFORMBUFFER_H_INCLUDED
+#define LAB471_UNIFORMBUFFER_H_INCLUDED
+
+#include <glad/glad.h>
+
+
+// A uniform buffer attached to a fixed binding point; programs reach it by
+// binding their uniform block to the same point (Program::bindUniformBlock)
+class UniformBuffer
+{
+
+public:
+
+	void init(GLsizeiptr size, GLuint binding);
+	void update(const void *data, GLsizeiptr size, GLintptr offset = 0) const;
+
+	template <typename T>
+	void update(const T &data) const { update(&data, sizeof(T)); }
+
+	GLuint getBinding() const { return binding; }
+
+private:
+
+	GLuint bufID = 0;
+	GLuint binding = 0;
+	GLsizeiptr size = 0;
+
+};
+
+#endif // LAB471_UNIFORMBUFFER_H_INCLUDED
@@ -5,6 +5,14 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <glad/glad.h>
 
 #include "GLSL.h"
@@ -13,6 +21,15 @@
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "UniformBuffer.h"
+#include "MaterialRegistry.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include "Headless.h"
+#include "FrameCapture.h"
+#include "RenderQueue.h"
+#include "MeshPool.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader/tiny_obj_loader.h>
@@ -37,6 +54,53 @@ public:
 	//Our shader program for textures
 	std::shared_ptr<Program> texProg;
 
+	//per-frame camera and light data, matches the std140 Frame block in the shaders
+	struct FrameData
+	{
+		mat4 P;
+		mat4 V;
+		vec4 lightPos;
+	};
+	static const GLuint FrameBinding = 0;
+	UniformBuffer frameUBO;
+
+	//every material in one uniform buffer, selected by index per draw
+	static const GLuint MaterialBinding = 1;
+	MaterialRegistry materials;
+
+	//uniform handles resolved once in init()
+	Uniform<mat4> texM;
+	Uniform<int> texSampler, texFlip;
+
+	//matrix stacks live for the whole run and are reset each frame (no per-frame allocation)
+	shared_ptr<MatrixStack> Projection = make_shared<MatrixStack>();
+	shared_ptr<MatrixStack> View = make_shared<MatrixStack>();
+	shared_ptr<MatrixStack> Model = make_shared<MatrixStack>();
+
+	//camera frustum for CPU culling, and last frame's submitted/culled object counts
+	Frustum frustum;
+	int gSubmitted = -1;
+	int gCulled = -1;
+
+	//per-pass CPU/GPU timings (--profile), optionally drawn as bars (P)
+	Profiler profiler;
+
+	//draws are queued each frame and issued sorted by program, texture and depth
+	RenderQueue renderQueue;
+	int passScene;
+	//draw calls for the queue, built once in init()
+	RenderQueue::Call drawPooled, drawGroundPlane;
+
+	//the sphere and bunny share buffers and draw together with one multi-draw
+	MeshPool meshPool;
+	int sphereMesh, bunnyMesh;
+
+	//frame recording (C or --capture): <prefix>NNNN.png, read back and encoded off the render thread
+	FrameCapture capture;
+	bool gCapturing = false;
+	std::string gCapturePrefix = "capture_";
+	int gCaptureFrame = 0;
+
 	//our geometry
 	shared_ptr<Shape> sphere;
 
@@ -47,10 +111,15 @@ public:
 	int g_GiboLen;
 	//ground VAO
 	GLuint GroundVertexArrayID;
+	//object-space bounds and placement of the ground quad (for culling)
+	vec3 gGroundMin, gGroundMax;
+	mat4 gGroundM = glm::translate(mat4(1.0f), vec3(0, -1, 0));
 
 	//the image to use as a texture (ground)
 	shared_ptr<Texture> texture0;
 	shared_ptr<Texture> texture1;	
+	//decodes textures in the background; grey placeholders show until then
+	TextureLoader textureLoader;
 
 	//global data (larger program should be encapsulated)
 	vec3 gMin;
@@ -58,10 +127,14 @@ public:
 	float gCamH = 0;
 	//animation data
 	float lightTrans = 0;
+	//bunnies per side of the instanced grid
+	int gGridDim = 3;
 	float gTrans = -3;
 	float sTheta = 0;
 	float eTheta = 0;
 	float hTheta = 0;
+	//animation clock override (headless runs use a fixed per-frame time)
+	double gFixedTime = -1;
 
 	void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
 	{
@@ -90,6 +163,15 @@ public:
 		if (key == GLFW_KEY_E && action == GLFW_PRESS){
 			lightTrans -= 0.5;
 		}
+		if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+			profiler.setOverlay(!profiler.hasOverlay());
+		}
+		if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+			gCapturing = !gCapturing;
+			if (!gCapturing) {
+				capture.finish();
+			}
+		}
 		if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
 			glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 		}
@@ -128,14 +210,9 @@ public:
 		prog->setVerbose(true);
 		prog->setShaderNames(resourceDirectory + "/simple_vert.glsl", resourceDirectory + "/simple_frag.glsl");
 		prog->init();
-		prog->addUniform("P");
-		prog->addUniform("V");
+		prog->bindUniformBlock("Frame", FrameBinding);
+		prog->bindUniformBlock("Materials", MaterialBinding);
 		prog->addUniform("M");
-		prog->addUniform("MatAmb");
-		prog->addUniform("MatDif");
-		prog->addUniform("MatSpec");
-		prog->addUniform("MatShine");
-		prog->addUniform("lightPos");
 		prog->addAttribute("vertPos");
 		prog->addAttribute("vertNor");
 
@@ -144,30 +221,35 @@ public:
 		texProg->setVerbose(true);
 		texProg->setShaderNames(resourceDirectory + "/tex_vert.glsl", resourceDirectory + "/tex_frag0.glsl");
 		texProg->init();
-		texProg->addUniform("P");
-		texProg->addUniform("V");
-		texProg->addUniform("M");
-		texProg->addUniform("flip");
-		texProg->addUniform("Texture0");
-		texProg->addUniform("MatShine");
-		texProg->addUniform("lightPos");
+		texProg->bindUniformBlock("Frame", FrameBinding);
+		texM = texProg->uniform<mat4>("M");
+		texFlip = texProg->uniform<int>("flip");
+		texSampler = texProg->uniform<int>("Texture0");
+		// constant for the whole run, so uploaded once here
+		texProg->bind();
+		texProg->uniform<float>("MatShine").set(27.9);
+		texProg->unbind();
 		texProg->addAttribute("vertPos");
 		texProg->addAttribute("vertNor");
 		texProg->addAttribute("vertTex");
 
+		frameUBO.init(sizeof(FrameData), FrameBinding);
+		initMaterials();
+
 		//read in a load the texture
 		texture0 = make_shared<Texture>();
   		texture0->setFilename(resourceDirectory + "/Caillebotte.jpg");
-  		texture0->init();
+  		textureLoader.load(texture0);
   		texture0->setUnit(0);
   		texture0->setWrapModes(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
   		texture1 = make_shared<Texture>();
   		texture1->setFilename(resourceDirectory + "/cartoonSky.png");
-  		texture1->init();
+  		textureLoader.load(texture1);
   		texture1->setUnit(1);
   		texture1->setWrapModes(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
+		initRenderQueue();
 	}
 
 	void initGeom(const std::string& resourceDirectory)
@@ -185,9 +267,11 @@ public:
 			cerr << errStr << endl;
 		} else {
 			sphere = make_shared<Shape>();
-			sphere->createShape(TOshapes[0]);
+			sphere->createShape(std::move(TOshapes[0]));
+			sphere->optimize();
 			sphere->measure();
-			sphere->init();
+			//drawn only through the pool, so the shape needs no buffers of its own
+			sphereMesh = meshPool.add(*sphere);
 		}
 		//read out information stored in the shape about its size - something like this...
 		//then do something with that information.....
@@ -203,13 +287,41 @@ public:
 			cerr << errStr << endl;
 		} else {	
 			theBunny = make_shared<Shape>();
-			theBunny->createShape(TOshapesB[0]);
+			theBunny->createShape(std::move(TOshapesB[0]));
+			theBunny->optimize();
 			theBunny->measure();
+			//its own buffers hold the culled instance set; the pool draws it
 			theBunny->init();
+			bunnyMesh = meshPool.add(*theBunny);
+			initBunnyGrid();
 		}
 
 		//code to load in the ground plane (CPU defined data passed to GPU)
 		initGround();
+
+		//upload the pooled meshes in one set of buffers
+		meshPool.init();
+	}
+
+	//lay out the bunny grid once as per-instance transforms
+	void initBunnyGrid() {
+		Model->reset();
+		vector<Shape::Instance> grid;
+		grid.reserve(gGridDim*gGridDim);
+
+		float dScale = 1.0/(theBunny->max.x-theBunny->min.x);
+		float sp = 3.0;
+		float off = -0.5 - sp*(gGridDim-1)/2.0;
+		for (int i =0; i < gGridDim; i++) {
+			for (int j=0; j < gGridDim; j++) {
+				Model->pushMatrix();
+					Model->translate(vec3(off+sp*i, -0.5, off+sp*j));
+					Model->scale(vec3(dScale));
+					grid.push_back({Model->topMatrix(), 0});
+				Model->popMatrix();
+			}
+		}
+		theBunny->setInstances(grid);
 	}
 
 	//directly pass quad for the ground to the GPU
@@ -225,6 +337,8 @@ public:
 			g_groundSize, g_groundY,  g_groundSize,
 			g_groundSize, g_groundY, -g_groundSize
 		};
+		gGroundMin = vec3(-g_groundSize, g_groundY, -g_groundSize);
+		gGroundMax = vec3(g_groundSize, g_groundY, g_groundSize);
 
 		float GrndNorm[] = {
 			0, 1, 0,
@@ -251,90 +365,96 @@ public:
       	glGenBuffers(1, &GrndBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndPos), GrndPos, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(0);
+      	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GrndNorBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndNorBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndNorm), GrndNorm, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(1);
+      	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GrndTexBuffObj);
       	glBindBuffer(GL_ARRAY_BUFFER, GrndTexBuffObj);
       	glBufferData(GL_ARRAY_BUFFER, sizeof(GrndTex), GrndTex, GL_STATIC_DRAW);
+      	glEnableVertexAttribArray(2);
+      	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
       	glGenBuffers(1, &GIndxBuffObj);
      	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GIndxBuffObj);
       	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+      	glBindVertexArray(0);
       }
 
-      //code to draw the ground plane
-     void drawGround(shared_ptr<Program> curS) {
-     	curS->bind();
+      //code to draw the ground plane (the render queue binds the program, texture and gGroundM)
+     void drawGround() {
      	glBindVertexArray(GroundVertexArrayID);
-     	texture0->bind(curS->getUniform("Texture0"));
-		//draw the ground plane 
-  		SetModel(vec3(0, -1, 0), 0, 0, 1, curS);
-  		glEnableVertexAttribArray(0);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndBuffObj);
-  		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-  		glEnableVertexAttribArray(1);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndNorBuffObj);
-  		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-  		glEnableVertexAttribArray(2);
-  		glBindBuffer(GL_ARRAY_BUFFER, GrndTexBuffObj);
-  		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-   		// draw!
-  		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GIndxBuffObj);
+   		// draw! (attribute layout is recorded in the ground VAO; positions are plain floats)
+  		glVertexAttrib3f(Shape::PosScaleAttrib, 1, 1, 1);
+  		glVertexAttrib3f(Shape::PosBiasAttrib, 0, 0, 0);
+  		// the ground VAO has no instance arrays either: identity transform and material 0,
+  		// whatever generic values the last draw left behind
+  		for (int c = 0; c < 4; c++) {
+  			glVertexAttrib4f(Shape::InstanceAttrib + c, c == 0, c == 1, c == 2, c == 3);
+  		}
+  		glVertexAttribI4i(Shape::InstanceAttrib + 4, 0, 0, 0, 0);
   		glDrawElements(GL_TRIANGLES, g_GiboLen, GL_UNSIGNED_SHORT, 0);
-
-  		glDisableVertexAttribArray(0);
-  		glDisableVertexAttribArray(1);
-  		glDisableVertexAttribArray(2);
-  		curS->unbind();
      }
 
-     //helper function to pass material data to the GPU
-	void SetMaterial(shared_ptr<Program> curS, int i) {
-
-    	switch (i) {
-    		case 0: //shiny blue plastic
-    			glUniform3f(curS->getUniform("MatAmb"), 0.096, 0.046, 0.095);
-    			glUniform3f(curS->getUniform("MatDif"), 0.96, 0.46, 0.95);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.45, 0.23, 0.45);
-    			glUniform1f(curS->getUniform("MatShine"), 120.0);
-    		break;
-    		case 1: // flat grey
-    			glUniform3f(curS->getUniform("MatAmb"), 0.063, 0.038, 0.1);
-    			glUniform3f(curS->getUniform("MatDif"), 0.63, 0.38, 1.0);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.3, 0.2, 0.5);
-    			glUniform1f(curS->getUniform("MatShine"), 4.0);
-    		break;
-    		case 2: //brass
-    			glUniform3f(curS->getUniform("MatAmb"), 0.004, 0.05, 0.09);
-    			glUniform3f(curS->getUniform("MatDif"), 0.04, 0.5, 0.9);
-    			glUniform3f(curS->getUniform("MatSpec"), 0.02, 0.25, 0.45);
-    			glUniform1f(curS->getUniform("MatShine"), 27.9);
-    		break;
-  		}
+	//one pass for the whole scene, and the draw calls the frame submits
+	void initRenderQueue() {
+		passScene = renderQueue.addPass("scene");
+
+		drawPooled = [this] { texFlip.set(1); meshPool.draw(); };
+		drawGroundPlane = [this] { texFlip.set(1); drawGround(); };
+	}
+
+	//queue a draw of call with the texture program; depth < 0 orders by the model's origin
+	void submitTextured(const mat4 &model, const shared_ptr<Texture> &texture, const RenderQueue::Call &call, float depth = -1.0f) {
+		RenderQueue::Draw draw;
+		draw.pass = passScene;
+		draw.program = texProg.get();
+		draw.texture = texture.get();
+		draw.sampler = texSampler;
+		draw.modelUniform = texM;
+		draw.model = model;
+		draw.depth = depth;
+		draw.call = &call;
+		renderQueue.submit(draw);
+	}
+
+     //register the scene materials once
+	void initMaterials() {
+		//shiny blue plastic
+		materials.add(vec3(0.096, 0.046, 0.095), vec3(0.96, 0.46, 0.95), vec3(0.45, 0.23, 0.45), 120.0);
+		// flat grey
+		materials.add(vec3(0.063, 0.038, 0.1), vec3(0.63, 0.38, 1.0), vec3(0.3, 0.2, 0.5), 4.0);
+		//brass
+		materials.add(vec3(0.004, 0.05, 0.09), vec3(0.04, 0.5, 0.9), vec3(0.02, 0.25, 0.45), 27.9);
+		materials.init(MaterialBinding);
 	}
 
 	/* helper function to set model trasnforms */
-  	void SetModel(vec3 trans, float rotY, float rotX, float sc, shared_ptr<Program> curS) {
+  	void SetModel(vec3 trans, float rotY, float rotX, float sc, const Uniform<mat4> &M) {
   		mat4 Trans = glm::translate( glm::mat4(1.0f), trans);
   		mat4 RotX = glm::rotate( glm::mat4(1.0f), rotX, vec3(1, 0, 0));
   		mat4 RotY = glm::rotate( glm::mat4(1.0f), rotY, vec3(0, 1, 0));
   		mat4 ScaleS = glm::scale(glm::mat4(1.0f), vec3(sc));
   		mat4 ctm = Trans*RotX*RotY*ScaleS;
-  		glUniformMatrix4fv(curS->getUniform("M"), 1, GL_FALSE, value_ptr(ctm));
+  		M.set(ctm);
   	}
 
-	void setModel(std::shared_ptr<Program> prog, std::shared_ptr<MatrixStack>M) {
-		glUniformMatrix4fv(prog->getUniform("M"), 1, GL_FALSE, value_ptr(M->topMatrix()));
-   	}
+	//print the submitted vs culled object counts whenever they change
+	void reportCulling(int submitted, int total) {
+		if (submitted != gSubmitted || total - submitted != gCulled) {
+			gSubmitted = submitted;
+			gCulled = total - submitted;
+			cout << "objects submitted " << gSubmitted << " culled " << gCulled << endl;
+		}
+	}
 
    	/* code to draw waving hierarchical model */
-   	void drawHierModel(shared_ptr<MatrixStack> Model, shared_ptr<Program> prog) {
+   	void drawHierModel(shared_ptr<MatrixStack> Model) {
    		// draw hierarchical mesh 
 		Model->pushMatrix();
 			Model->loadIdentity();
@@ -343,14 +463,12 @@ public:
 			Model->pushMatrix();
 				Model->translate(vec3(0, 1.4, 0));
 				Model->scale(vec3(0.5, 0.5, 0.5));
-				setModel(prog, Model);
-				sphere->draw(prog);
+				meshPool.submit(sphereMesh, Model->topMatrix());
 			Model->popMatrix();
 			//draw the torso with these transforms
 			Model->pushMatrix();
 			  Model->scale(vec3(1.15, 1.35, 1.0));
-			  setModel(prog, Model);
-			  sphere->draw(prog);
+			  meshPool.submit(sphereMesh, Model->topMatrix());
 			Model->popMatrix();
 			// draw the upper 'arm' - relative 
 			Model->pushMatrix();
@@ -371,18 +489,15 @@ public:
 			      Model->rotate(hTheta, vec3(0, 0, 1));
 			      Model->translate(vec3(0.2, 0, 0));
 			      Model->scale(vec3(0.4, 0.25, 0.25));
-			      setModel(prog, Model);
-			      sphere->draw(prog);
+			      meshPool.submit(sphereMesh, Model->topMatrix());
 			    Model->popMatrix();
 				 //fore arm scale
 			    Model->scale(vec3(0.6, 0.25, 0.25));
-			    setModel(prog, Model);
-			    sphere->draw(prog);
+			    meshPool.submit(sphereMesh, Model->topMatrix());
 			  Model->popMatrix();
 			  //upper arm scale
 			  Model->scale(vec3(0.8, 0.25, 0.25));
-			  setModel(prog, Model);
-			  sphere->draw(prog);
+			  meshPool.submit(sphereMesh, Model->topMatrix());
 			Model->popMatrix();
 			//left arm
 			Model->pushMatrix();
@@ -403,22 +518,26 @@ public:
 			      Model->rotate(-0.3, vec3(0, 0, 1));
 			      Model->translate(vec3(-0.2, 0, 0));
 			      Model->scale(vec3(0.4, 0.25, 0.25));
-			      setModel(prog, Model);
-			      sphere->draw(prog);
+			      meshPool.submit(sphereMesh, Model->topMatrix());
 			    Model->popMatrix();
 				 //arm scale
 			    Model->scale(vec3(0.6, 0.25, 0.25));
-			    setModel(prog, Model);
-			    sphere->draw(prog);
+			    meshPool.submit(sphereMesh, Model->topMatrix());
 			  Model->popMatrix();
 			  //non-uniform scale
 			  Model->scale(vec3(0.8, 0.25, 0.25));
-			  setModel(prog, Model);
-			  sphere->draw(prog);
+			  meshPool.submit(sphereMesh, Model->topMatrix());
 		Model->popMatrix();
    	}
 
 	void render() {
+		profiler.beginFrame();
+
+		// Finish at most one background texture load per frame
+		profiler.begin("upload");
+		textureLoader.update();
+		profiler.end();
+
 		// Get current frame buffer size.
 		int width, height;
 		glfwGetFramebufferSize(windowManager->getHandle(), &width, &height);
@@ -430,10 +549,10 @@ public:
 		//Use the matrix stack for Lab 6
 		float aspect = width/(float)height;
 
-		// Create the matrix stacks - please leave these alone for now
-		auto Projection = make_shared<MatrixStack>();
-		auto View = make_shared<MatrixStack>();
-		auto Model = make_shared<MatrixStack>();
+		// Start the matrix stacks from identity - please leave these alone for now
+		Projection->reset();
+		View->reset();
+		Model->reset();
 
 		// Apply perspective projection.
 		Projection->pushMatrix();
@@ -447,72 +566,62 @@ public:
 		//global rotate (the whole scene )
 		View->rotate(gRot, vec3(0, 1, 0));
 
-		// Draw the scene
-		texProg->bind();
-		glUniformMatrix4fv(texProg->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(texProg->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		glUniform3f(texProg->getUniform("lightPos"), 2.0+lightTrans, 2.0, 2.9);
-		glUniform1f(texProg->getUniform("MatShine"), 27.9);
-		glUniform1i(texProg->getUniform("flip"), 1);
-		texture1->bind(texProg->getUniform("Texture0"));
-		// draw the array of bunnies
-		Model->pushMatrix();
+		// Camera and light go to the shared Frame block once for all programs
+		FrameData frame = {Projection->topMatrix(), View->topMatrix(), vec4(2.0+lightTrans, 2.0, 2.9, 1.0)};
+		frameUBO.update(frame);
 
-		float dScale = 1.0/(theBunny->max.x-theBunny->min.x);
-		float sp = 3.0;
-		float off = -3.5;
-		  for (int i =0; i < 3; i++) {
-		  	for (int j=0; j < 3; j++) {
-			  Model->pushMatrix();
-				Model->translate(vec3(off+sp*i, -0.5, off+sp*j));
-				Model->scale(vec3(dScale));
-				//SetMaterial(texProg, (i+j)%3);
-				glUniformMatrix4fv(texProg->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-				theBunny->draw(texProg);
-			  Model->popMatrix();
-			}
-		  }
-		Model->popMatrix();
+		// Cull the bunny grid and ground against the camera (the sky sphere always draws)
+		frustum.extract(Projection->topMatrix() * View->topMatrix());
+		int visibleBunnies = theBunny->cullInstances(frustum);
+		bool groundVisible = frustum.intersects(gGroundMin, gGroundMax, gGroundM);
+		reportCulling(visibleBunnies + (groundVisible ? 1 : 0), gGridDim*gGridDim + 1);
+
+		// Queue the scene; the queue groups it by texture and skips state that is already bound
+		renderQueue.begin(View->topMatrix());
 
-		//draw the waving HM
-		//SetMaterial(texProg, 1);
-		texture1->bind(texProg->getUniform("Texture0"));
-		drawHierModel(Model, texProg);
+		// the array of bunnies, the waving HM and the big background sphere go to the
+		// mesh pool and draw with the same texture as one batch
+		meshPool.clear();
+		meshPool.submit(bunnyMesh, theBunny->getVisibleInstances());
+
+		drawHierModel(Model);
 
-		//draw big background sphere
-		glUniform1i(texProg->getUniform("flip"), 0);
-		texture1->bind(texProg->getUniform("Texture0"));
 		Model->pushMatrix();
 			Model->loadIdentity();
 			Model->scale(vec3(8.0));
-			setModel(texProg, Model);
-			sphere->draw(texProg);
+			meshPool.submit(sphereMesh, Model->topMatrix());
 		Model->popMatrix();
 
-		texProg->unbind();
+		meshPool.upload();
+		submitTextured(mat4(1.0f), texture1, drawPooled);
 
-		//switch shaders to the texture mapping shader and draw the ground
-		texProg->bind();
-		glUniformMatrix4fv(texProg->getUniform("P"), 1, GL_FALSE, value_ptr(Projection->topMatrix()));
-		glUniformMatrix4fv(texProg->getUniform("V"), 1, GL_FALSE, value_ptr(View->topMatrix()));
-		glUniformMatrix4fv(texProg->getUniform("M"), 1, GL_FALSE, value_ptr(Model->topMatrix()));
-		glUniform3f(texProg->getUniform("lightPos"), 2.0+lightTrans, 2.0, 2.9);
-		glUniform1f(texProg->getUniform("MatShine"), 27.9);	
-		glUniform1i(texProg->getUniform("flip"), 1);
-		
-		drawGround(texProg);
+		//the ground with the same texture program
+		if (groundVisible) {
+			submitTextured(gGroundM, texture0, drawGroundPlane);
+		}
 
-		texProg->unbind();
+		renderQueue.execute(&profiler);
+		renderQueue.reportChanges();
+
+		profiler.drawOverlay(width, height);
+
+		if (gCapturing) {
+			char number[16];
+			snprintf(number, sizeof(number), "%04d", gCaptureFrame++);
+			capture.capture(gCapturePrefix + number + ".png", width, height);
+		}
 		
 		//animation update example
-		sTheta = sin(glfwGetTime());
-		eTheta = std::max(0.0f, (float)sin(glfwGetTime()));
-		hTheta = std::max(0.0f, (float)cos(glfwGetTime()));
+		double time = gFixedTime >= 0 ? gFixedTime : glfwGetTime();
+		sTheta = sin(time);
+		eTheta = std::max(0.0f, (float)sin(time));
+		hTheta = std::max(0.0f, (float)cos(time));
 
 		// Pop matrix stacks.
 		Projection->popMatrix();
 		View->popMatrix();
 
+		profiler.endFrame();
 	}
 };
 
@@ -520,19 +629,94 @@ int main(int argc, char *argv[])
 {
 	// Where the resources are loaded from
 	std::string resourceDir = "../resources";
+	Application *application = new Application();
+
+	// Profiling flags may appear anywhere; the rest are positional
+	//   --profile             print per-pass CPU/GPU averages every 60 frames
+	//   --profile-csv <file>  also write every sample to a CSV file
+	//   --profile-overlay     start with the timing bars on screen (toggle with P)
+	// Headless benchmarking (hidden window, offscreen framebuffer, fixed clock)
+	//   --headless <frames>   render this many frames, print frame time statistics and exit
+	//   --size <w>x<h>        resolution (default 640x480)
+	//   --dump <prefix>       save the last frame as <prefix>NNNN.png
+	//   --dump-every <n>      save every n-th frame instead
+	// Recording in either mode (also toggled with C)
+	//   --capture <prefix>    save every frame as <prefix>NNNN.png
+	// Mesh pool
+	//   --no-indirect         draw pooled meshes one command at a time, as without GL 4.3
+	Headless headless;
+	std::string dumpPrefix;
+	int dumpEvery = 0;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--profile")
+		{
+			application->profiler.setEnabled(true);
+		}
+		else if (arg == "--profile-csv" && i + 1 < argc)
+		{
+			if (application->profiler.openCsv(argv[++i]))
+			{
+				application->profiler.setEnabled(true);
+			}
+		}
+		else if (arg == "--profile-overlay")
+		{
+			application->profiler.setOverlay(true);
+		}
+		else if (arg == "--headless" && i + 1 < argc)
+		{
+			headless.setFrames(atoi(argv[++i]));
+		}
+		else if (arg == "--size" && i + 1 < argc)
+		{
+			int w = 0, h = 0;
+			if (sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+			{
+				headless.setSize(w, h);
+			}
+		}
+		else if (arg == "--dump" && i + 1 < argc)
+		{
+			dumpPrefix = argv[++i];
+		}
+		else if (arg == "--dump-every" && i + 1 < argc)
+		{
+			dumpEvery = std::max(0, atoi(argv[++i]));
+		}
+		else if (arg == "--capture" && i + 1 < argc)
+		{
+			application->gCapturePrefix = argv[++i];
+			application->gCapturing = true;
+		}
+		else if (arg == "--no-indirect")
+		{
+			application->meshPool.setIndirect(false);
+		}
+		else
+		{
+			args.push_back(arg);
+		}
+	}
 
-	if (argc >= 2)
+	if (args.size() >= 1)
 	{
-		resourceDir = argv[1];
+		resourceDir = args[0];
 	}
 
-	Application *application = new Application();
+	// Optional size of the instanced bunny grid (per side)
+	if (args.size() >= 2)
+	{
+		application->gGridDim = std::max(1, atoi(args[1].c_str()));
+	}
 
 	// Your main will always include a similar set up to establish your window
 	// and GL context, etc.
 
 	WindowManager *windowManager = new WindowManager();
-	windowManager->init(640, 480);
+	windowManager->init(headless.getWidth(), headless.getHeight(), !headless.isEnabled());
 	windowManager->setEventCallbacks(application);
 	application->windowManager = windowManager;
 
@@ -542,6 +726,33 @@ int main(int argc, char *argv[])
 	application->init(resourceDir);
 	application->initGeom(resourceDir);
 
+	if (headless.isEnabled())
+	{
+		headless.setDump(dumpPrefix, dumpEvery);
+		if (!headless.init())
+		{
+			return EXIT_FAILURE;
+		}
+		// Every frame should show the real textures, not the loading placeholder
+		while (application->textureLoader.busy())
+		{
+			application->textureLoader.update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		while (!headless.done())
+		{
+			headless.beginFrame();
+			application->gFixedTime = headless.time();
+			application->render();
+			headless.endFrame();
+			glfwPollEvents();
+		}
+		headless.report();
+		application->capture.finish();
+		windowManager->shutdown();
+		return 0;
+	}
+
 	// Loop until the user closes the window.
 	while (! glfwWindowShouldClose(windowManager->getHandle()))
 	{
@@ -555,6 +766,7 @@ int main(int argc, char *argv[])
 	}
 
 	// Quit program.
+	application->capture.finish();
 	windowManager->shutdown();
 	return 0;
 }
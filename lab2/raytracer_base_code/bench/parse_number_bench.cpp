@@ -0,0 +1,90 @@
+// Cost per numeric token of rt::parse_double next to strtod and istream >> double
+// (what the loader used before), over the vertex coordinates of OBJ files, plus
+// the time of the whole load_obj_positions_indices.
+//   parse_number_bench [file.obj ...]   (default ../assets/dragon_res3.obj)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "obj_loader.h"
+
+namespace {
+using clock_type=std::chrono::steady_clock;
+
+// Best of a few rounds, each at least ~0.2 s, in ns per call of body (which handles count tokens)
+template<class F> double ns_per_token(size_t count, F body){
+    double best=1e30;
+    for(int round=0;round<3;++round){
+        size_t runs=0; auto start=clock_type::now(); double ns=0;
+        do { body(); ++runs; ns=std::chrono::duration<double,std::nano>(clock_type::now()-start).count(); } while(ns<2e8);
+        best=std::min(best,ns/double(runs*count));
+    }
+    return best;
+}
+} // namespace
+
+int main(int argc, char** argv){
+    std::vector<std::string> paths(argv+1,argv+argc);
+    if(paths.empty()) paths.push_back("../assets/dragon_res3.obj");
+    std::printf("%-28s %9s %12s %9s %9s %11s\n","file","tokens","parse_double","strtod","istream","load (ms)");
+    for(const std::string& path: paths){
+        std::ifstream in(path, std::ios::binary);
+        if(!in.is_open()){ std::fprintf(stderr,"cannot open %s\n",path.c_str()); return 1; }
+        std::stringstream ss; ss<<in.rdbuf(); std::string text=ss.str();
+
+        // The three coordinates of every "v" line, each NUL-terminated for strtod
+        std::string tokens; std::vector<size_t> starts;
+        std::istringstream lines(text); std::string line;
+        while(std::getline(lines,line)){
+            std::istringstream ls(line); std::string head, c;
+            if(!(ls>>head) || head!="v") continue;
+            for(int k=0;k<3 && (ls>>c);++k){ starts.push_back(tokens.size()); tokens+=c; tokens+='\0'; }
+        }
+        if(starts.empty()){ std::fprintf(stderr,"%s has no vertices\n",path.c_str()); continue; }
+        const char* base=tokens.data();
+
+        volatile double sink=0;
+        double fast=ns_per_token(starts.size(),[&]{
+            double sum=0, v=0;
+            for(size_t s: starts){ const char* t=base+s; rt::parse_double(t,t+std::strlen(t),v); sum+=v; }
+            sink=sum;
+        });
+        double libc=ns_per_token(starts.size(),[&]{
+            double sum=0;
+            for(size_t s: starts) sum+=std::strtod(base+s,nullptr);
+            sink=sum;
+        });
+        double stream=ns_per_token(starts.size(),[&]{
+            double sum=0, v=0;
+            for(size_t s: starts){ std::istringstream is(base+s); is>>v; sum+=v; }
+            sink=sum;
+        });
+
+        // Every token must agree with strtod bit for bit
+        size_t mismatches=0;
+        for(size_t s: starts){
+            const char* t=base+s; double v=0;
+            rt::parse_double(t,t+std::strlen(t),v);
+            double expect=std::strtod(t,nullptr);
+            if(std::memcmp(&v,&expect,sizeof(v))!=0) ++mismatches;
+        }
+
+        std::vector<rt::Vec3> V; std::vector<uint32_t> I; double best=1e30;
+        for(int round=0;round<5;++round){
+            auto start=clock_type::now();
+            rt::load_obj_positions_indices(path,V,I);
+            best=std::min(best,std::chrono::duration<double,std::milli>(clock_type::now()-start).count());
+        }
+
+        std::string name=path.substr(path.find_last_of("/\\")+1);
+        std::printf("%-28s %9zu %9.1f ns %6.1f ns %6.1f ns %11.2f%s\n",name.c_str(),starts.size(),fast,libc,stream,best,
+                    mismatches? "  MISMATCH" : "");
+        if(mismatches) return 1;
+    }
+    return 0;
+}
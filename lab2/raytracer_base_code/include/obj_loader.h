@@ -2,25 +2,57 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
 #include "triangle.h"
 #include "scene.h"
+#include "parse_number.h"
 namespace rt {
+// OBJ whitespace as std::istream sees it
+inline bool is_obj_space(char c){ return c==' '||c=='\t'||c=='\r'||c=='\v'||c=='\f'; }
+inline const char* skip_obj_space(const char* p,const char* end){ while(p!=end && is_obj_space(*p)) ++p; return p; }
+inline const char* obj_token_end(const char* p,const char* end){ while(p!=end && !is_obj_space(*p)) ++p; return p; }
+
+// Reads the whole file once and parses the lines in place: positions and
+// triangle-fan indices only, with no per-line allocation
 inline bool load_obj_positions_indices(const std::string& path, std::vector<Vec3>& outV, std::vector<uint32_t>& outI){
-    std::ifstream in(path); 
-    if(!in.is_open()) return false; 
-    std::string line; 
+    std::ifstream in(path, std::ios::binary);
+    if(!in.is_open()) return false;
+    in.seekg(0,std::ios::end); std::string text(size_t(in.tellg()),'\0');
+    in.seekg(0); in.read(&text[0],std::streamsize(text.size()));
     outV.clear(); outI.clear();
 
-    auto parse_index=[](const std::string& tok)->int{ size_t s=tok.find('/'); if(s==std::string::npos) return std::stoi(tok); return std::stoi(tok.substr(0,s)); };
-    while(std::getline(in,line)){ if(line.empty()||line[0]=='#') continue; std::istringstream iss(line); std::string h; iss>>h;
-        if(h=="v"){ double x,y,z; iss>>x>>y>>z; outV.push_back({x,y,z}); }
-        else if(h=="f"){ std::vector<int> idx; std::string tok; while(iss>>tok){ idx.push_back(parse_index(tok)); } if(idx.size()<3) continue;
-            for(size_t i=1;i+1<idx.size();++i){ outI.push_back((uint32_t)(idx[0]-1)); outI.push_back((uint32_t)(idx[i]-1)); outI.push_back((uint32_t)(idx[i+1]-1)); } }
-    } return true;
+    std::vector<int> idx;
+    const char* p=text.data(); const char* const file_end=p+text.size();
+    while(p<file_end){
+        const char* end=static_cast<const char*>(std::memchr(p,'\n',size_t(file_end-p)));
+        if(!end) end=file_end;
+        const char* line=p; p=end+1;
+        if(line==end || line[0]=='#') continue;
+        const char* t=skip_obj_space(line,end); const char* te=obj_token_end(t,end);
+        if(te-t!=1) continue;
+        if(*t=='v'){
+            double c[3]={0,0,0};
+            for(double& x: c){ t=skip_obj_space(te,end); te=obj_token_end(t,end); parse_double(t,te,x); }
+            outV.push_back({c[0],c[1],c[2]});
+        } else if(*t=='f'){
+            // v, v/vt, v//vn or v/vt/vn: only the position index is kept
+            idx.clear();
+            for(t=skip_obj_space(te,end); t!=end; t=skip_obj_space(te,end)){
+                te=obj_token_end(t,end);
+                const char* d=t; bool negative=false; int v=0;
+                if(d!=te && (*d=='+'||*d=='-')){ negative=*d=='-'; ++d; }
+                if(d==te || unsigned(*d-'0')>=10) return false;
+                for(; d!=te && unsigned(*d-'0')<10; ++d) v=v*10+(*d-'0');
+                idx.push_back(negative? -v : v);
+            }
+            if(idx.size()<3) continue;
+            for(size_t i=1;i+1<idx.size();++i){ outI.push_back((uint32_t)(idx[0]-1)); outI.push_back((uint32_t)(idx[i]-1)); outI.push_back((uint32_t)(idx[i+1]-1)); }
+        }
+    }
+    return true;
 }
 
 inline void add_mesh(Scene& sc,const std::vector<Vec3>& V,const std::vector<uint32_t>& I,int matId,const Vec3& scale={1,1,1},const Vec3& translate={0,0,0}){
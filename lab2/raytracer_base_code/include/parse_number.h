@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+namespace rt {
+// Numeric tokens of OBJ files. This is the same kernel as tryParseDouble in the
+// lab1_C++ copies of tiny_obj_loader (this project does not share their tree).
+
+namespace detail {
+// Eight ASCII digits at a time (SWAR); reads 8 bytes little-endian
+inline uint64_t load_eight(const char* p){ uint64_t v; std::memcpy(&v,p,sizeof(v)); return v; }
+
+inline bool is_eight_digits(uint64_t v){
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+inline uint64_t parse_eight_digits(uint64_t v){
+    const uint64_t mask=0x000000FF000000FFull;
+    const uint64_t mul1=0x000F424000000064ull; // 100 + (1000000 << 32)
+    const uint64_t mul2=0x0000271000000001ull; // 1 + (10000 << 32)
+    v-=0x3030303030303030ull;
+    v=(v*10)+(v>>8);
+    return (((v&mask)*mul1)+(((v>>16)&mask)*mul2))>>32;
+}
+
+// Digits go into the mantissa while it can hold them (19); later ones only count in dropped
+inline const char* scan_digits(const char* p,const char* end,uint64_t& mantissa,int& digits,int& dropped){
+    while(end-p>=8 && digits<=11){
+        uint64_t v=load_eight(p);
+        if(!is_eight_digits(v)) break;
+        mantissa=mantissa*100000000+parse_eight_digits(v); digits+=8; p+=8;
+    }
+    for(; p!=end && unsigned(*p-'0')<10; ++p){
+        if(digits<19){ mantissa=mantissa*10+unsigned(*p-'0'); ++digits; }
+        else ++dropped;
+    }
+    return p;
+}
+} // namespace detail
+
+// Parses [sign] digits [. digits] [(e|E) [sign] digits] from [s, end) into out,
+// correctly rounded like strtod. Returns the end of the number, or s if there is
+// none. A mantissa of at most 2^53 (any 15 significant digits) times a power of
+// ten within 1e22 is exact with one multiply or divide (Clinger's fast path);
+// anything else, longer mantissas included, goes to strtod.
+inline const char* parse_double(const char* s,const char* end,double& out){
+    static const double pow10[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                 1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    const char* p=s;
+    bool negative=false;
+    if(p!=end && (*p=='+'||*p=='-')){ negative=*p=='-'; ++p; }
+
+    uint64_t mantissa=0; int digits=0, dropped=0;
+    const char* first=p;
+    while(p!=end && *p=='0') ++p; // leading zeros take no mantissa digits
+    bool any=p!=first;
+    const char* int_start=p;
+    p=detail::scan_digits(p,end,mantissa,digits,dropped);
+    any=any||p!=int_start;
+    int exponent=dropped;
+
+    if(p!=end && *p=='.'){
+        ++p;
+        const char* frac_start=p;
+        if(mantissa==0){ while(p!=end && *p=='0') ++p; exponent-=int(p-frac_start); }
+        int before=digits;
+        p=detail::scan_digits(p,end,mantissa,digits,dropped);
+        exponent-=digits-before;
+        any=any||p!=frac_start;
+    }
+    if(!any) return s;
+
+    // An 'e' without digits after it is not part of the number
+    if(p!=end && (*p=='e'||*p=='E')){
+        const char* e=p+1; bool exp_negative=false;
+        if(e!=end && (*e=='+'||*e=='-')){ exp_negative=*e=='-'; ++e; }
+        if(e!=end && unsigned(*e-'0')<10){
+            int value=0;
+            for(; e!=end && unsigned(*e-'0')<10; ++e) if(value<100000) value=value*10+(*e-'0');
+            exponent+=exp_negative? -value : value;
+            p=e;
+        }
+    }
+
+    if(mantissa==0){ out=negative? -0.0 : 0.0; return p; }
+    if(dropped==0 && mantissa<=(1ull<<53) && exponent>=-22 && exponent<=22){
+        double v=double(mantissa);
+        v=exponent<0? v/pow10[-exponent] : v*pow10[exponent];
+        out=negative? -v : v;
+        return p;
+    }
+    // Rare: too many digits or a huge exponent
+    std::string text(s,p);
+    out=std::strtod(text.c_str(),nullptr);
+    return p;
+}
+} // namespace rt
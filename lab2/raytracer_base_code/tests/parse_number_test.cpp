@@ -0,0 +1,95 @@
+// Round-trip check of rt::parse_double against strtod: edge tokens, sampled
+// floats (%.9g) and doubles (%.17g, %.15g, %.6f) and random decimal strings
+// must give the same bits and end at the same character.
+//   parse_number_test               sampled (run by ctest)
+//   parse_number_test --exhaustive  every finite float (about an hour)
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "parse_number.h"
+
+namespace {
+uint64_t checked=0, failures=0;
+
+uint64_t bits_of(double d){ uint64_t b; std::memcpy(&b,&d,sizeof(b)); return b; }
+
+// Compares with strtod over the whole token; a token strtod cannot read must be rejected
+void check(const char* token){
+    const char* end=token+std::strlen(token);
+    char* expect_end=nullptr;
+    double expect=std::strtod(token,&expect_end);
+    double got=-1.0;
+    const char* got_end=rt::parse_double(token,end,got);
+    bool ok= expect_end==token? got_end==token : got_end==expect_end && bits_of(got)==bits_of(expect);
+    ++checked;
+    if(!ok && ++failures<=20)
+        std::printf("MISMATCH \"%s\": got %.17g (%d chars), strtod %.17g (%d chars)\n",
+                    token,got,int(got_end-token),expect,int(expect_end-token));
+}
+
+void check_float(uint32_t b){
+    float f; std::memcpy(&f,&b,sizeof(f));
+    if(f!=f || f-f!=0.0f) return; // NaN and infinities are not OBJ numbers
+    char s[64]; std::snprintf(s,sizeof(s),"%.9g",double(f));
+    check(s);
+    // %.9g is enough for the float to survive the trip through double
+    const char* end=s+std::strlen(s); double d=0;
+    rt::parse_double(s,end,d);
+    float back=float(d); uint32_t back_bits; std::memcpy(&back_bits,&back,sizeof(back_bits));
+    if(back_bits!=b && ++failures<=20) std::printf("ROUND TRIP %08x -> \"%s\" -> %08x\n",unsigned(b),s,unsigned(back_bits));
+}
+
+uint64_t xorshift(uint64_t& s){ s^=s<<13; s^=s>>7; s^=s<<17; return s; }
+} // namespace
+
+int main(int argc, char** argv){
+    if(argc>1 && std::strcmp(argv[1],"--exhaustive")==0){
+        for(uint64_t b=0;b<=0xFFFFFFFFull;++b) check_float(uint32_t(b));
+        std::printf("exhaustive: %llu tokens, %llu failures\n",(unsigned long long)checked,(unsigned long long)failures);
+        return failures? 1 : 0;
+    }
+
+    static const char* edges[]={
+        "0","-0","+0","0.0","-0.0","00","0e0","-0e-5",".5","-.5","+.5e-3","5.","5.e2","1e","1e+","1E-","1.5e","1.5ex","2e3x",
+        "1e22","1e23","-1e-22","1e-23","9007199254740992","9007199254740993","-9007199254740993e-5","18446744073709551615",
+        "18446744073709551616","123456789012345678901234567890","0.123456789012345678901234567890","12345678901234567890.5",
+        "3.14159265358979323846264338327950288","00000000000000000000000001.25","0.00000000000000000000000000000000000001",
+        "1e308","-1e308","1.7976931348623157e308","1.7976931348623159e308","1e309","-1e309","1e-308","2.2250738585072014e-308",
+        "4.9406564584124654e-324","2.4703282292062328e-324","1e-324","1e-400","1e99999999999","1e-99999999999",
+        "0.000000000000000000000000000000001e33","100000000000000000000000e-23","7.038531e-26","1.17549435e-38","3.40282347e38",
+        ".","-",".e1","+.e1","e5","-e5","abc","",
+    };
+    for(const char* token: edges) check(token);
+    uint64_t edge_count=checked;
+
+    // Floats across every exponent, with a stride that reaches all mantissa bit positions
+    for(uint64_t b=0;b<=0xFFFFFFFFull;b+=997) check_float(uint32_t(b));
+    uint64_t float_count=checked-edge_count;
+
+    uint64_t seed=0x9E3779B97F4A7C15ull;
+    static const char* formats[]={"%.17g","%.15g","%.6f"};
+    for(int i=0;i<300000;++i){
+        uint64_t b=xorshift(seed); double d; std::memcpy(&d,&b,sizeof(d));
+        if(d!=d || d-d!=0.0) continue;
+        char s[512];
+        // %.6f of large values runs to hundreds of digits, which only strtod can round
+        for(const char* format: formats){ std::snprintf(s,sizeof(s),format,d); check(s); }
+    }
+
+    // Decimal strings as exporters and hand edits write them: short and long mantissas,
+    // leading zeros, optional point and exponent
+    for(int i=0;i<300000;++i){
+        char s[64]; int n=0; uint64_t r=xorshift(seed);
+        if(r&1) s[n++]=(r&2)? '-' : '+';
+        int digits=1+int((r>>2)%25), point=int((r>>8)%(digits+1));
+        for(int k=0;k<digits;++k){ if(k==point && (r>>13&1)) s[n++]='.'; s[n++]=char('0'+xorshift(seed)%10); }
+        if(r>>14&1) n+=std::snprintf(s+n,sizeof(s)-size_t(n),"e%d",int((r>>16)%80)-40);
+        s[n]='\0'; check(s);
+    }
+
+    std::printf("%llu edge tokens, %llu sampled floats, %llu doubles and decimal strings: %llu failures\n",
+                (unsigned long long)edge_count,(unsigned long long)float_count,
+                (unsigned long long)(checked-edge_count-float_count),(unsigned long long)failures);
+    return failures? 1 : 0;
+}